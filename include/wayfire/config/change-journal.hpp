@@ -0,0 +1,80 @@
+#pragma once
+
+#include <wayfire/config/config-manager.hpp>
+
+namespace wf
+{
+namespace config
+{
+/**
+ * Records the changes to the values of options, so that they can be undone
+ * and redone.
+ *
+ * For each change, the journal stores the old and the new value of the option
+ * in string form, in a ring buffer of bounded size. When the buffer is full,
+ * the oldest transactions are forgotten as a whole. A transaction with more
+ * changes than fit into the buffer cannot be undone, so when it overflows, all
+ * recorded changes are forgotten, and the rest of the transaction is not
+ * recorded.
+ *
+ * Dynamic-list options (see compound_option_t) cannot be represented as a
+ * string, so changes to them are not recorded.
+ */
+class change_journal_t
+{
+  public:
+    /**
+     * Start recording changes to the options in all sections of @manager.
+     *
+     * @param capacity The maximal number of changes to remember.
+     */
+    change_journal_t(config_manager_t& manager, size_t capacity = 1024);
+    ~change_journal_t();
+
+    change_journal_t(const change_journal_t& other) = delete;
+    change_journal_t& operator =(const change_journal_t& other) = delete;
+
+    /**
+     * Start recording changes to the options in @section as well, for example
+     * for a section which was added to the config manager after the journal
+     * was created. Options which are already watched are skipped.
+     */
+    void watch_section(const std::shared_ptr<section_t>& section);
+
+    /**
+     * Group all changes until the matching end_transaction() into a single
+     * transaction, which is undone and redone as a whole.
+     *
+     * Transactions can be nested, in which case the outermost transaction
+     * determines the group.
+     */
+    void begin_transaction();
+    void end_transaction();
+
+    /** @return true if there is a transaction which can be undone. */
+    bool can_undo() const;
+
+    /** @return true if there is an undone transaction which can be redone. */
+    bool can_redo() const;
+
+    /**
+     * Restore the old values of the options changed in the last transaction.
+     * @return false if there was nothing to undo.
+     */
+    bool undo();
+
+    /**
+     * Apply the last undone transaction again.
+     * @return false if there was nothing to redo.
+     */
+    bool redo();
+
+    /** Forget all recorded changes. */
+    void clear();
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> priv;
+};
+}
+}
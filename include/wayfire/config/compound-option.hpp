@@ -6,12 +6,16 @@
 #include <wayfire/util/log.hpp>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <any>
 #include <cassert>
 
 namespace wf
 {
 namespace config
 {
+class section_t;
+
 template<class... Args>
 using compound_list_t =
     std::vector<std::tuple<std::string, Args...>>;
@@ -59,9 +63,19 @@ class compound_option_entry_base_t
     /**
      * Try to parse the given value.
      *
-     * @param update Whether to override the stored value.
+     * @param cell Set to the parsed value if parsing succeeds.
+     * @return Whether the value is valid for this entry.
+     */
+    virtual bool parse(const std::string& str, std::any& cell) const = 0;
+
+    /**
+     * Check whether the given value is valid for this entry.
      */
-    virtual bool is_parsable(const std::string&) const = 0;
+    bool is_parsable(const std::string& str) const
+    {
+        std::any cell;
+        return parse(str, cell);
+    }
 
     /** Clone this entry */
     virtual compound_option_entry_base_t *clone() const = 0;
@@ -88,14 +102,16 @@ class compound_option_entry_t : public compound_option_entry_base_t
             this->get_name());
     }
 
-    /**
-     * Try to parse the given value.
-     *
-     * @param update Whether to override the stored value.
-     */
-    bool is_parsable(const std::string& str) const override
+    bool parse(const std::string& str, std::any& cell) const override
     {
-        return option_type::from_string<Type>(str).has_value();
+        auto value = option_type::from_string<Type>(str);
+        if (value)
+        {
+            cell = std::move(value.value());
+            return true;
+        }
+
+        return false;
     }
 };
 
@@ -148,7 +164,35 @@ class compound_option_t : public option_base_t
     {
         compound_list_t<Args...> result;
         result.resize(value.size());
-        build_recursive<0, Args...>(result);
+        for (size_t i = 0; i < result.size(); i++)
+        {
+            build_recursive<0, Args...>(i, result[i]);
+        }
+
+        return result;
+    }
+
+    /**
+     * Find the tuple whose first element is @key. Only the found tuple is
+     * converted to the given types, the rest of the list is not touched.
+     *
+     * If multiple tuples have the same key, the first one is returned.
+     *
+     * Throws an exception in case of wrong template types.
+     */
+    template<class... Args>
+    stdx::optional<std::tuple<std::string, Args...>> find(
+        const std::string& key) const
+    {
+        assert(sizeof...(Args) == this->entries.size());
+        auto it = key_index.find(key);
+        if (it == key_index.end())
+        {
+            return {};
+        }
+
+        std::tuple<std::string, Args...> result;
+        build_recursive<0, Args...>(it->second, result);
         return result;
     }
 
@@ -175,7 +219,9 @@ class compound_option_t : public option_base_t
     {
         assert(sizeof...(Args) == this->entries.size());
         this->value.assign(value.size(), {});
+        this->cells.assign(value.size(), {});
         push_recursive<0>(value);
+        rebuild_key_index();
         notify_updated();
     }
 
@@ -200,12 +246,15 @@ class compound_option_t : public option_base_t
     /**
      * Get the string data stored in the compound option.
      */
-    stored_type_t get_value_untyped();
+    const stored_type_t& get_value_untyped() const;
 
     /**
      * Set the data contained in the option, from a vector containing
      * strings which describe the individual elements.
      *
+     * The new value is swapped in, so passing an rvalue does not copy the
+     * list.
+     *
      * @return True if the operation was successful.
      */
     bool set_value_untyped(stored_type_t value);
@@ -231,32 +280,61 @@ class compound_option_t : public option_base_t
      */
     stored_type_t value;
 
+    /**
+     * The parsed values of the stored strings, cells[i][n - 1] holds the
+     * parsed value of value[i][n]. Filled when the strings are validated, so
+     * that get_value() does not need to parse them again.
+     */
+    std::vector<std::vector<std::any>> cells;
+
+    /** Maps the first element of each tuple to its index in value. */
+    std::unordered_map<std::string, size_t> key_index;
+
     /** Entry types with which the option was created. */
     entries_t entries;
 
+    void rebuild_key_index();
+
+    /** Swap in a value whose cells were already parsed and validated. */
+    void set_parsed_value(stored_type_t&& value,
+        std::vector<std::vector<std::any>>&& cells);
+
+    friend void update_compound_from_section(compound_option_t& option,
+        const std::shared_ptr<section_t>& section);
+
     /** What type of dynamic-list is this: plain, dics, tuple */
     std::string list_type_hint;
 
     /**
-     * Set the n-th element in the result tuples by reading from the stored
-     * values in this option.
+     * Set the n-th element of @result by reading from the stored values of the
+     * row-th tuple in this option.
      */
     template<size_t n, class... Args>
-    void build_recursive(compound_list_t<Args...>& result) const
+    void build_recursive(size_t row,
+        std::tuple<std::string, Args...>& result) const
     {
-        for (size_t i = 0; i < result.size(); i++)
+        using type_t = typename std::tuple_element<n,
+            std::tuple<std::string, Args...>>::type;
+
+        const type_t *parsed = nullptr;
+        if constexpr (n > 0)
         {
-            using type_t = typename std::tuple_element<n,
-                std::tuple<std::string, Args...>>::type;
+            parsed = std::any_cast<type_t>(&this->cells[row][n - 1]);
+        }
 
-            std::get<n>(result[i]) = option_type::from_string<type_t>(
-                this->value[i][n]).value();
+        if (parsed)
+        {
+            std::get<n>(result) = *parsed;
+        } else
+        {
+            std::get<n>(result) = option_type::from_string<type_t>(
+                this->value[row][n]).value();
         }
 
         // Recursively build the (N+1)'th entries
         if constexpr (n < sizeof...(Args))
         {
-            build_recursive<n + 1>(result);
+            build_recursive<n + 1>(row, result);
         }
     }
 
@@ -270,6 +348,10 @@ class compound_option_t : public option_base_t
 
             this->value[i].push_back(option_type::to_string<type_t>(
                 std::get<n>(new_value[i])));
+            if constexpr (n > 0)
+            {
+                this->cells[i].emplace_back(std::get<n>(new_value[i]));
+            }
         }
 
         // Recursively build the (N+1)'th entries
@@ -286,6 +368,7 @@ class compound_option_t : public option_base_t
     bool set_default_value_str(const std::string&) override;
     std::string get_value_str() const override;
     std::string get_default_value_str() const override;
+    bool assign_from(const option_base_t& other) override;
 };
 }
 }
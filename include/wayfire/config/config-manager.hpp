@@ -1,6 +1,9 @@
 #pragma once
 
 #include <wayfire/config/section.hpp>
+#include <chrono>
+#include <functional>
+#include <stdint.h>
 
 namespace wf
 {
@@ -9,6 +12,12 @@ namespace config
 /**
  * Manages the whole configuration of a program.
  * The configuration consists of a list of sections with their options.
+ *
+ * The const methods do not modify the config manager, so they may be called
+ * from multiple threads at the same time, as long as no non-const method runs
+ * concurrently. In particular, the const lookups never run section loaders
+ * (see add_section_loader()), they only see the sections which have already
+ * been loaded.
  */
 class config_manager_t
 {
@@ -22,17 +31,117 @@ class config_manager_t
      */
     void merge_section(std::shared_ptr<section_t> section);
 
+    /**
+     * A function which creates a section on demand, or returns nullptr if the
+     * section could not be created.
+     */
+    using section_loader_t = std::function<std::shared_ptr<section_t>()>;
+
+    /**
+     * Register a loader for the section with the given name. The loader is run
+     * the first time the section is looked up with the non-const get_section(),
+     * get_option(), find_sections() or find_options(), or right before a
+     * section with the same name is merged, and the section it returns is
+     * merged into the configuration.
+     *
+     * Multiple loaders may be registered for the same section, they are run in
+     * the order in which they were added.
+     */
+    void add_section_loader(const std::string& name, section_loader_t loader);
+
+    /**
+     * Run all loaders which have not been run yet.
+     */
+    void load_all_sections();
+
     /**
      * Find the configuration section with the given name.
+     * If a loader is registered for the section, it is run first.
+     *
      * @return nullptr if the section doesn't exist.
      */
+    std::shared_ptr<section_t> get_section(const std::string& name);
+
+    /**
+     * Same as get_section(), but only finds sections which have already been
+     * loaded.
+     */
     std::shared_ptr<section_t> get_section(const std::string& name) const;
 
+    /**
+     * Remove the section with the given name, as well as any loaders which
+     * have not been run for it yet. No-op if there is no such section.
+     */
+    void remove_section(const std::string& name);
+
+    /**
+     * @return The sections whose name has the form <type>:<name>, where both
+     *   parts are non-empty, for the given object type, in the order in
+     *   which they were added. For example, get_object_instances("output")
+     *   returns all [output:*] sections.
+     */
+    const std::vector<std::shared_ptr<section_t>>& get_object_instances(
+        const std::string& type) const;
+
+    /**
+     * A function to be executed when an instance of an object type is added
+     * to (@added = true) or removed from the config manager.
+     */
+    using instance_callback_t =
+        std::function<void (const std::shared_ptr<section_t>& section,
+            bool added)>;
+
+    /**
+     * Register a new callback to execute when an instance of the given object
+     * type is added or removed.
+     */
+    void add_instance_handler(const std::string& type,
+        instance_callback_t *callback);
+
+    /**
+     * Unregister a callback registered with add_instance_handler().
+     */
+    void rem_instance_handler(const std::string& type,
+        instance_callback_t *callback);
+
     /**
      * @return A list of all sections currently in the config manager.
+     *   Sections whose loaders have not been run yet are not included.
      */
     std::vector<std::shared_ptr<section_t>> get_all_sections() const;
 
+    /**
+     * @return A list of the sections whose name matches the shell-style
+     *   pattern @pattern (see fnmatch(3)), for example "output:*", sorted by
+     *   name. Only the sections whose name begins with the part of @pattern
+     *   before the first wildcard are tested, and matching sections which
+     *   have a loader are loaded.
+     */
+    std::vector<std::shared_ptr<section_t>> find_sections(
+        const std::string& pattern);
+
+    /**
+     * Same as find_sections(), but only finds sections which have already
+     * been loaded.
+     */
+    std::vector<std::shared_ptr<section_t>> find_sections(
+        const std::string& pattern) const;
+
+    /**
+     * Find options by a pattern of the form <section pattern>/<option pattern>,
+     * for example "command/binding_*". Both parts are matched as in
+     * find_sections() and section_t::find_options().
+     *
+     * @return A list of the matching options, sorted by section and option
+     *   name.
+     */
+    std::vector<std::shared_ptr<option_base_t>> find_options(
+        const std::string& pattern);
+
+    /** Same as find_options(), but only in sections already loaded. */
+    std::vector<std::shared_ptr<option_base_t>> find_options(
+        const std::string& pattern) const;
+
     /**
      * Get the option with the given name.
      * The name consists of the name of the option section, followed by a '/',
@@ -41,18 +150,183 @@ class config_manager_t
      *
      * If the option doesn't exist, nullptr is returned.
      */
+    std::shared_ptr<option_base_t> get_option(const std::string& name);
+
+    /** Same as get_option(), but only in sections already loaded. */
     std::shared_ptr<option_base_t> get_option(const std::string& name) const;
 
     /**
      * Get the option with the given name. Same semantics as
      * get_option(std::string), but casts the result to the appropriate type.
      */
+    template<class T>
+    std::shared_ptr<option_t<T>> get_option(const std::string& name)
+    {
+        return std::dynamic_pointer_cast<option_t<T>>(get_option(name));
+    }
+
     template<class T>
     std::shared_ptr<option_t<T>> get_option(const std::string& name) const
     {
         return std::dynamic_pointer_cast<option_t<T>>(get_option(name));
     }
 
+    /**
+     * Store the sections, and the options of each section, in sorted arrays
+     * instead of trees, which makes lookups and iteration faster. This is
+     * meant to be done once the set of sections and options stops changing,
+     * for example after startup.
+     *
+     * Adding or removing sections afterwards automatically undoes this for
+     * the config manager, and registering or unregistering options undoes it
+     * for the affected section (see section_t::freeze()).
+     */
+    void freeze();
+
+    /** @return Whether the config manager is frozen, see freeze(). */
+    bool is_frozen() const;
+
+    /**
+     * A dense integer index of an option in the config manager, see
+     * assign_option_ids().
+     */
+    using option_id_t = uint32_t;
+    static constexpr option_id_t INVALID_OPTION_ID = UINT32_MAX;
+
+    /**
+     * An option ID which has been checked to refer to an option of type T.
+     */
+    template<class T>
+    struct typed_option_id_t
+    {
+        option_id_t id = INVALID_OPTION_ID;
+    };
+
+    /**
+     * Assign an ID to each option of the loaded sections which does not have
+     * one yet. IDs are assigned consecutively starting from 0, in order of
+     * section and option name. Sections which have a loader are not loaded.
+     *
+     * Afterwards, the options of sections merged later, for example by a
+     * section loader, get their IDs when they are merged, so the IDs depend on
+     * the order in which sections are loaded. Options registered directly in
+     * a section get an ID on the next call.
+     *
+     * An option loses its ID when its section is removed, when it is
+     * unregistered from its section, or when it is replaced by another option
+     * with the same name. IDs are not reused. Because they depend on the
+     * loaded sections, IDs are only valid for the lifetime of the config
+     * manager, and must not be stored or compiled into plugins.
+     *
+     * @return The number of assigned IDs, that is, one more than the largest ID.
+     */
+    size_t assign_option_ids();
+
+    /**
+     * @return The ID of the option with the given name (as in get_option()),
+     *   or INVALID_OPTION_ID if the option does not exist or has no ID.
+     */
+    option_id_t get_option_id(const std::string& name);
+    option_id_t get_option_id(const std::string& name) const;
+
+    /**
+     * Same as get_option_id(), but also checks that the option has type T.
+     * The resulting ID is invalid if the option has another type.
+     */
+    template<class T>
+    typed_option_id_t<T> get_option_id(const std::string& name)
+    {
+        return check_option_id<T>(get_option_id(name));
+    }
+
+    template<class T>
+    typed_option_id_t<T> get_option_id(const std::string& name) const
+    {
+        return check_option_id<T>(get_option_id(name));
+    }
+
+    /**
+     * @return The option with the given ID, or nullptr if the ID is invalid or
+     *   the option has lost its ID, see assign_option_ids().
+     */
+    option_base_t *get_option_by_id(option_id_t id) const;
+
+    /**
+     * Same as get_option_by_id(option_id_t), but without a type check.
+     */
+    template<class T>
+    option_t<T> *get_option_by_id(typed_option_id_t<T> id) const
+    {
+        return static_cast<option_t<T>*>(get_option_by_id(id.id));
+    }
+
+    /**
+     * Start saving the configuration to @file in the background whenever an
+     * option changes. Changes are coalesced, and the file is written at most
+     * once per @interval, the first time @interval after a change.
+     *
+     * The options are never accessed from the background thread, instead, a
+     * copy of each changed option is made when the change happens. Only the
+     * options of sections which are in the config manager when auto-persist is
+     * enabled, or which are merged later, are watched.
+     *
+     * Pending changes are saved when auto-persist is disabled, or when the
+     * config manager is destroyed.
+     */
+    void enable_auto_persist(const std::string& file,
+        std::chrono::milliseconds interval);
+
+    /**
+     * Save any pending changes and stop saving the configuration in the
+     * background. Does nothing if auto-persist is not enabled.
+     */
+    void disable_auto_persist();
+
+    /**
+     * Block until all changes made so far have been saved by auto-persist.
+     */
+    void flush_auto_persist();
+
+    /**
+     * Defer the updated handlers of options which are changed from another
+     * thread than the calling one (the owner), for example when the
+     * configuration is reloaded in the background. The notifications are
+     * queued without locking, and the handlers are run on the owner thread by
+     * dispatch_notifications(). Options changed from the owner thread still
+     * notify their handlers right away.
+     *
+     * Multiple changes of the same option before the next dispatch result in
+     * a single notification. Only the options of sections which are in the
+     * config manager when the queue is enabled, or which are merged later,
+     * are deferred. Enabling and disabling the queue, as well as merging and
+     * removing sections, must not happen concurrently with changes of the
+     * options from other threads.
+     *
+     * @return A file descriptor which becomes readable when there are
+     *   notifications to dispatch. It is owned by the config manager.
+     * @throws std::system_error if the file descriptor could not be created.
+     */
+    int enable_notification_queue();
+
+    /**
+     * Dispatch any pending notifications and stop deferring them. Does
+     * nothing if the notification queue is not enabled.
+     */
+    void disable_notification_queue();
+
+    /**
+     * Run the updated handlers of all options changed from other threads
+     * since the last dispatch. Must be called from the owner thread.
+     */
+    void dispatch_notifications();
+
+    /**
+     * Log the statistics of the updated handlers of all options, collected
+     * while profiling was enabled (see option_base_t::set_profiling()), with
+     * the handlers which took the most time in total first.
+     */
+    void log_notification_profile() const;
+
     config_manager_t();
     config_manager_t(config_manager_t&& other);
     config_manager_t& operator =(config_manager_t&& other);
@@ -62,6 +336,19 @@ class config_manager_t
   private:
     struct impl;
     std::unique_ptr<impl> priv;
+
+    /** @return @id if it refers to an option of type T, an invalid ID otherwise. */
+    template<class T>
+    typed_option_id_t<T> check_option_id(option_id_t id) const
+    {
+        typed_option_id_t<T> result;
+        if (dynamic_cast<option_t<T>*>(get_option_by_id(id)))
+        {
+            result.id = id;
+        }
+
+        return result;
+    }
 };
 }
 }
@@ -35,6 +35,47 @@ namespace config
 void load_configuration_options_from_string(config_manager_t& manager,
     const std::string& source, const std::string& source_name = "");
 
+/**
+ * A parser which reads a configuration in the format described in
+ * load_configuration_options_from_string() in arbitrary chunks, for example as
+ * they arrive on a pipe or socket, without buffering the whole source.
+ *
+ * Each complete line is applied to the config manager as soon as it has been
+ * fed, also when it was split across chunks. Options which did not appear in
+ * the source are reset and the compound options are rebuilt only in finish(),
+ * so that feeding a whole source and calling finish() has the same effect as
+ * load_configuration_options_from_string().
+ */
+class config_stream_parser_t
+{
+  public:
+    /**
+     * @param manager The config manager to update. It must outlive the parser.
+     * @param source_name The name to be used when reporting errors to the log
+     */
+    config_stream_parser_t(config_manager_t& manager,
+        const std::string& source_name = "");
+    ~config_stream_parser_t();
+
+    config_stream_parser_t(const config_stream_parser_t& other) = delete;
+    config_stream_parser_t& operator =(const config_stream_parser_t& other) =
+        delete;
+
+    /** Parse the next @size bytes of the source. */
+    void feed(const char *data, size_t size);
+
+    /**
+     * Apply the last line, if it is not terminated by a newline, and reset the
+     * options which were not in the source. Afterwards, the parser can be used
+     * to read a new source.
+     */
+    void finish();
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> priv;
+};
+
 /**
  * Create a string which conttains all the sections and the options in the given
  * configuration manager. The format is the same one as the one described in
@@ -45,6 +86,27 @@ void load_configuration_options_from_string(config_manager_t& manager,
 std::string save_configuration_options_to_string(
     const config_manager_t& manager);
 
+/**
+ * A function which receives consecutive chunks of serialized configuration.
+ */
+using config_writer_t = std::function<void (const char *data, size_t size)>;
+
+/**
+ * Serialize the configuration in the same format as
+ * save_configuration_options_to_string(), but pass the result to @write in
+ * chunks of a few kilobytes instead of building the whole string in memory.
+ */
+void save_configuration_options(const config_manager_t& manager,
+    const config_writer_t& write);
+
+/**
+ * Serialize the configuration like save_configuration_options(), and write it
+ * to the given file descriptor.
+ *
+ * @return false if writing to @fd failed.
+ */
+bool save_configuration_options_to_fd(const config_manager_t& manager, int fd);
+
 /**
  * Load the options from the given config file.
  *
@@ -62,14 +124,61 @@ std::string save_configuration_options_to_string(
 bool load_configuration_options_from_file(config_manager_t& manager,
     const std::string& file);
 
+/**
+ * How save_configuration_to_file() writes the config file.
+ */
+enum config_save_mode_t
+{
+    /*
+     * Truncate the config file and write the new contents into it. The last
+     * newline is written after the exclusive lock has been released, so that
+     * programs watching the file (e.g. with inotify's IN_MODIFY) get one last
+     * event at a time when they can take a shared lock and reload it.
+     */
+    CONFIG_SAVE_IN_PLACE = 0,
+    /*
+     * Write the new contents to a temporary file '<file>.tmp-<pid>' in the same
+     * directory, and rename it over the config file (or over the target of the
+     * config file, if it is a symlink) after the exclusive lock has been
+     * released. The config file is left unchanged if writing fails.
+     *
+     * This changes the protocol for other programs: watches on the config file
+     * itself are dropped when it is replaced, so they have to watch the
+     * directory for IN_MOVED_TO instead. Because each save creates a new inode,
+     * the lock only keeps writers apart if they lock the file they opened
+     * after the rename. Hard links are broken, only the file mode is kept (not
+     * the owner, ACLs or extended attributes), and the directory has to be
+     * writable.
+     */
+    CONFIG_SAVE_REPLACE  = 1,
+};
+
 /**
  * Writes the options in the given configuration to the given file.
  * It is roughly equivalent to calling serialize_configuration_manager() and
  * then replacing the file contents with the resulting string, but this function
  * waits until it can get an exclusive lock on the config file.
+ *
+ * See config_save_mode_t for how the file is written.
  */
 void save_configuration_to_file(const config_manager_t& manager,
-    const std::string& file);
+    const std::string& file, config_save_mode_t mode = CONFIG_SAVE_IN_PLACE);
+
+/**
+ * How build_configuration() reads the XML files.
+ */
+enum xml_loading_mode_t
+{
+    /* Read all XML files while building the configuration */
+    XML_LOAD_ALL                 = 0,
+    /* Read an XML file only when its section is first needed */
+    XML_LOAD_ON_DEMAND           = 1,
+    /* Like XML_LOAD_ALL, but stream the XML files instead of keeping their
+     * document trees, see xml::load_section_from_file() */
+    XML_LOAD_STREAMING           = 2,
+    /* Like XML_LOAD_ON_DEMAND, but stream the XML files */
+    XML_LOAD_ON_DEMAND_STREAMING = 3,
+};
 
 /**
  * Build a configuration for the given program from the files on the filesystem.
@@ -83,8 +192,63 @@ void save_configuration_to_file(const config_manager_t& manager,
  *
  * If any of the steps results in an error, the error will be reported to the
  * command line and the process will continue.
+ *
+ * With XML_LOAD_ON_DEMAND and XML_LOAD_ON_DEMAND_STREAMING, the XML files are
+ * only indexed by their file name, which has to be the section name followed
+ * by '.xml'. Each file is read when its section is first looked up, e.g.
+ * because it appears in @sysconf or @userconf, or because the plugin is listed
+ * in core/plugins.
  */
 config_manager_t build_configuration(const std::vector<std::string>& xmldirs,
-    const std::string& sysconf, const std::string& userconf);
+    const std::string& sysconf, const std::string& userconf,
+    xml_loading_mode_t mode = XML_LOAD_ALL);
+
+/**
+ * The options of a program, with their types, bounds and default values, as
+ * described by the XML files and the system config file (steps 1 and 2 of
+ * build_configuration()).
+ *
+ * A schema is immutable once built, and can be shared by many configurations,
+ * for example one per user or seat, so that the XML files are parsed once.
+ */
+class config_schema_t
+{
+  public:
+    /**
+     * Read all XML files in @xmldirs, and use @sysconf to overwrite the default
+     * values from the XML files.
+     */
+    config_schema_t(const std::vector<std::string>& xmldirs,
+        const std::string& sysconf);
+    ~config_schema_t();
+
+    config_schema_t(const config_schema_t& other) = delete;
+    config_schema_t& operator =(const config_schema_t& other) = delete;
+
+    /**
+     * Create a new configuration with the options of the schema, set to their
+     * default values. Each section is copied from the schema the first time
+     * it is looked up, so creating a configuration is cheap, and it only
+     * stores the sections which are actually used.
+     *
+     * May be called from multiple threads at the same time. The configuration
+     * keeps the parts of the schema it needs alive.
+     */
+    config_manager_t create_configuration() const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> priv;
+};
+
+/**
+ * Build a configuration from a schema, and load the actual values of the
+ * options from @userconf (step 3 of build_configuration()).
+ *
+ * The sections of the plugins listed in core/plugins are loaded right away,
+ * like with XML_LOAD_ON_DEMAND.
+ */
+config_manager_t build_configuration(const config_schema_t& schema,
+    const std::string& userconf);
 }
 }
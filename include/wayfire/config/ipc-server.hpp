@@ -0,0 +1,74 @@
+#pragma once
+
+#include <wayfire/config/config-manager.hpp>
+
+namespace wf
+{
+namespace config
+{
+/**
+ * A server which gives other processes access to the options of a config
+ * manager over a local UNIX socket.
+ *
+ * Messages in both directions are frames, consisting of a 32-bit length in
+ * host byte order, followed by that many bytes of payload. The payload of a
+ * request is a batch of commands, one per line:
+ *
+ * get <section>/<option>
+ * set <section>/<option> <value>
+ * subscribe <section>/<option>
+ * unsubscribe <section>/<option>
+ *
+ * The server answers each request with a single frame, which contains one
+ * line per command, in the same order: either "ok", followed by a space and
+ * the option value for get and subscribe, or "error <message>".
+ *
+ * When a subscribed option changes, a frame with the line
+ * "changed <section>/<option> <value>" is sent to the subscribed client.
+ * Clients therefore have to tell responses and change events apart by their
+ * first word. If a client's own request changes an option it is subscribed
+ * to, the change event is sent after the response to that request.
+ *
+ * The server does not use any threads. It has to be driven by the event loop
+ * of the program which owns the config manager, by calling dispatch()
+ * whenever the file descriptor returned by get_fd() becomes readable.
+ *
+ * Change events are sent from the updated handlers of the options, so the
+ * subscribed options must only be changed on the thread which calls
+ * dispatch(), unless the notification queue of the config manager is enabled
+ * (see config_manager_t::enable_notification_queue()) and dispatched on that
+ * thread.
+ */
+class ipc_server_t
+{
+  public:
+    /**
+     * Start listening on @socket_path. An existing file at @socket_path is
+     * replaced, and the socket is removed when the server is destroyed.
+     *
+     * @throws std::system_error if the socket could not be created.
+     */
+    ipc_server_t(config_manager_t& manager, const std::string& socket_path);
+    ~ipc_server_t();
+
+    ipc_server_t(const ipc_server_t& other) = delete;
+    ipc_server_t& operator =(const ipc_server_t& other) = delete;
+
+    /**
+     * @return A file descriptor which becomes readable when the server has
+     *   work to do.
+     */
+    int get_fd() const;
+
+    /**
+     * Accept new clients, handle their requests and send pending output,
+     * without blocking.
+     */
+    void dispatch();
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> priv;
+};
+}
+}
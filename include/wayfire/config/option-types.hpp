@@ -26,5 +26,31 @@ stdx::optional<Type> from_string(
  */
 template<class Type>
 std::string to_string(const Type& value);
+
+/**
+ * Append the string representation of a value to @out, which is the same as
+ * the one produced by to_string().
+ *
+ * The built-in types specialize append_to so that a single output buffer can
+ * be reused without creating a temporary string per value. Other types fall
+ * back to appending the result of to_string().
+ */
+template<class Type>
+void append_to(std::string& out, const Type& value)
+{
+    out += to_string<Type>(value);
+}
+
+template<>
+void append_to<bool>(std::string& out, const bool& value);
+
+template<>
+void append_to<int>(std::string& out, const int& value);
+
+template<>
+void append_to<double>(std::string& out, const double& value);
+
+template<>
+void append_to<std::string>(std::string& out, const std::string& value);
 }
 }
@@ -1,8 +1,15 @@
 #pragma once
 
 #include <wayfire/config/option-types.hpp>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
 #include <functional>
 #include <limits>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
 
 #include <memory>
 
@@ -49,6 +56,22 @@ class option_base_t
     /** Get the option value in string format */
     virtual std::string get_value_str() const = 0;
 
+    /**
+     * Append the option value in string format to @out.
+     * The default implementation appends the result of get_value_str().
+     */
+    virtual void append_value_str(std::string& out) const;
+
+    /**
+     * Set the value of this option to the value of @other, without converting
+     * it to a string and back.
+     *
+     * @return true if @other has the same type as this option and its value was
+     *   copied, false if the types differ (the default implementation always
+     *   returns false).
+     */
+    virtual bool assign_from(const option_base_t& other);
+
     /** Get the default option value in string format */
     virtual std::string get_default_value_str() const = 0;
 
@@ -69,6 +92,38 @@ class option_base_t
      */
     void rem_updated_handler(updated_callback_t *callback);
 
+    /**
+     * Statistics about the calls of one updated handler of an option.
+     */
+    struct handler_profile_t
+    {
+        updated_callback_t *handler;
+        /** The number of calls */
+        uint64_t calls = 0;
+        /** The total and the longest duration of a call */
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds max{0};
+    };
+
+    /**
+     * Enable or disable measuring the duration of the updated handlers of all
+     * options. Profiling is disabled by default, in which case notifying the
+     * handlers costs a single additional check.
+     */
+    static void set_profiling(bool enabled = true);
+
+    /** @return Whether profiling of updated handlers is enabled. */
+    static bool is_profiling();
+
+    /**
+     * @return The statistics of the updated handlers of this option which were
+     *   called while profiling was enabled, in the order of their first call.
+     */
+    std::vector<handler_profile_t> get_handler_profile() const;
+
+    /** Forget the statistics collected for the updated handlers. */
+    void reset_handler_profile();
+
     /**
      * Set the lock status of an option, this is reference-counted.
      *
@@ -85,9 +140,16 @@ class option_base_t
      */
     bool is_locked() const;
 
+    /** Metadata which is rarely accessed, like the name and the XML node. */
     struct impl;
     std::unique_ptr<impl> priv;
 
+  private:
+    /* Data needed on every read or change of the option is kept inline, next
+     * to the value, instead of in the separately allocated impl. */
+    int32_t lock_count = 0;
+    std::vector<updated_callback_t*> updated_handlers;
+
   protected:
     /** Construct a new option with the given name. */
     option_base_t(const std::string& name);
@@ -107,7 +169,7 @@ template<class Type, bool enable_bounds>
 class bounded_option_base_t
 {
   protected:
-    Type closest_valid_value(const Type& value) const
+    const Type& closest_valid_value(const Type& value) const
     {
         return value;
     }
@@ -164,6 +226,120 @@ namespace detail
 {
 template<class Type, class Result> using boundable_type_only =
     std::enable_if_t<std::is_arithmetic<Type>::value, Result>;
+
+/**
+ * Whether options of the given type can be read from any thread with
+ * option_t::get_value_atomic(), see option_t::enable_atomic_reads().
+ */
+template<class Type>
+constexpr bool is_atomic_readable = std::is_trivially_copyable<Type>::value;
+
+template<class Type, class Result = Type> using atomic_readable_only =
+    std::enable_if_t<is_atomic_readable<Type>, Result>;
+
+/**
+ * A copy of a trivially copyable value which a single thread can update while
+ * other threads read it.
+ *
+ * Values which fit in a lock-free std::atomic are stored in one, so reads are
+ * wait-free. Larger values are protected by a sequence counter: a read is
+ * retried if it overlapped with a write, so it never returns a torn value.
+ */
+template<class Type,
+    bool lock_free = (sizeof(Type) <= sizeof(uint64_t)) &&
+    std::atomic<Type>::is_always_lock_free>
+class atomic_cell_t
+{
+  public:
+    atomic_cell_t(const Type& value) : cell(value)
+    {}
+
+    void store(const Type& value)
+    {
+        cell.store(value, std::memory_order_release);
+    }
+
+    Type load() const
+    {
+        return cell.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::atomic<Type> cell;
+};
+
+template<class Type>
+class atomic_cell_t<Type, false>
+{
+  public:
+    atomic_cell_t(const Type& value)
+    {
+        store(value);
+    }
+
+    void store(const Type& value)
+    {
+        uint64_t buffer[NUM_WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(Type));
+
+        /* An odd sequence number marks a write in progress */
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < NUM_WORDS; i++)
+        {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    Type load() const
+    {
+        alignas(Type) unsigned char buffer[NUM_WORDS * sizeof(uint64_t)];
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < NUM_WORDS; i++)
+            {
+                uint64_t word = words[i].load(std::memory_order_relaxed);
+                std::memcpy(buffer + i * sizeof(uint64_t), &word, sizeof(word));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before != after) || (before & 1));
+
+        static_assert(std::is_default_constructible<Type>::value,
+            "Large atomic-readable types need a default constructor");
+        Type value;
+        std::memcpy(&value, buffer, sizeof(Type));
+        return value;
+    }
+
+  private:
+    static constexpr size_t NUM_WORDS =
+        (sizeof(Type) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint64_t> words[NUM_WORDS];
+};
+
+/** Used instead of atomic_cell_t for types which are not atomic-readable. */
+struct no_atomic_cell_t
+{};
+
+template<class Type, bool = is_atomic_readable<Type>>
+struct atomic_cell_for
+{
+    using type = no_atomic_cell_t;
+};
+
+template<class Type>
+struct atomic_cell_for<Type, true>
+{
+    using type = atomic_cell_t<Type>;
+};
 }
 
 /**
@@ -178,7 +354,8 @@ class option_t : public option_base_t,
      * Create a new option with the given name and default value.
      */
     option_t(const std::string& name, Type def_value) :
-        option_base_t(name), default_value(def_value), value(default_value)
+        option_base_t(name), value(def_value),
+        default_value(std::move(def_value))
     {}
 
     /**
@@ -194,6 +371,14 @@ class option_t : public option_base_t,
             result->maximum = this->maximum;
         }
 
+        if constexpr (detail::is_atomic_readable<Type>)
+        {
+            if (this->atomic_value)
+            {
+                result->enable_atomic_reads();
+            }
+        }
+
         init_clone(*result);
         return result;
     }
@@ -208,7 +393,7 @@ class option_t : public option_base_t,
         auto new_value = option_type::from_string<Type>(new_value_str);
         if (new_value)
         {
-            set_value(new_value.value());
+            set_value(std::move(new_value.value()));
             return true;
         }
 
@@ -231,7 +416,7 @@ class option_t : public option_base_t,
         auto parsed = option_type::from_string<Type>(defvalue);
         if (parsed)
         {
-            this->default_value = parsed.value();
+            this->default_value = std::move(parsed.value());
             return true;
         }
 
@@ -245,27 +430,96 @@ class option_t : public option_base_t,
      */
     void set_value(const Type& new_value)
     {
-        auto real_value = this->closest_valid_value(new_value);
-        if (!(this->value == real_value))
+        assign_value(this->closest_valid_value(new_value));
+    }
+
+    /**
+     * Set the value of the option, moving from @new_value if the value
+     * actually changes.
+     */
+    void set_value(Type&& new_value)
+    {
+        if constexpr (std::is_arithmetic<Type>::value)
+        {
+            assign_value(this->closest_valid_value(new_value));
+        } else
         {
-            this->value = real_value;
-            this->notify_updated();
+            assign_value(std::move(new_value));
         }
     }
 
-    Type get_value() const
+    /**
+     * Get the current value of the option. The returned reference is changed
+     * by set_value(), so this must be called from the thread which modifies
+     * the option.
+     */
+    const Type& get_value() const
     {
         return value;
     }
 
-    Type get_default_value() const
+    /**
+     * Keep a copy of the value which other threads can read with
+     * get_value_atomic(). Afterwards, every change of the value also updates
+     * the copy, so options which are only used on one thread should not
+     * enable this.
+     *
+     * This must be called on the thread which modifies the option, before
+     * the option is shared with other threads. It is kept by clones.
+     *
+     * Available only for trivially copyable types, like bool, int, double,
+     * color_t, keybinding_t and buttonbinding_t.
+     */
+    template<class U = Type>
+    detail::atomic_readable_only<U, void> enable_atomic_reads()
+    {
+        if (!atomic_value)
+        {
+            atomic_value = std::make_unique<detail::atomic_cell_t<Type>>(value);
+        }
+    }
+
+    /**
+     * Get a copy of the current value of the option. Unlike get_value(), this
+     * may be called from any thread, concurrently with set_value() and the
+     * other setters on the thread which modifies the option.
+     *
+     * Requires enable_atomic_reads() to have been called.
+     */
+    template<class U = Type>
+    detail::atomic_readable_only<U> get_value_atomic() const
+    {
+        assert(atomic_value);
+        return atomic_value->load();
+    }
+
+    const Type& get_default_value() const
     {
         return default_value;
     }
 
     virtual std::string get_value_str() const override
     {
-        return option_type::to_string<Type>(get_value());
+        std::string result;
+        append_value_str(result);
+        return result;
+    }
+
+    virtual void append_value_str(std::string& out) const override
+    {
+        option_type::append_to<Type>(out, value);
+    }
+
+    virtual bool assign_from(const option_base_t& other) override
+    {
+        auto typed = dynamic_cast<const option_t<Type>*>(&other);
+        if (typed)
+        {
+            set_value(typed->get_value());
+            return true;
+        }
+
+        return false;
     }
 
     virtual std::string get_default_value_str() const override
@@ -283,7 +537,7 @@ class option_t : public option_base_t,
     detail::boundable_type_only<Type, U> set_minimum(Type min)
     {
         this->minimum = {min};
-        this->value   = this->closest_valid_value(this->value);
+        assign_value(this->closest_valid_value(this->value), false);
     }
 
     /**
@@ -295,12 +549,40 @@ class option_t : public option_base_t,
     detail::boundable_type_only<Type, U> set_maximum(Type max)
     {
         this->maximum = {max};
-        this->value   = this->closest_valid_value(this->value);
+        assign_value(this->closest_valid_value(this->value), false);
     }
 
   protected:
-    Type default_value; /* default value */
     Type value; /* current value */
+    Type default_value; /* default value */
+
+    /* A copy of the current value for get_value_atomic(), if enabled */
+    std::unique_ptr<typename detail::atomic_cell_for<Type>::type> atomic_value;
+
+    /**
+     * Store an already clamped value and notify the updated handlers if
+     * @notify is set, unless it is the same as the current value.
+     */
+    template<class U>
+    void assign_value(U&& new_value, bool notify = true)
+    {
+        if (!(this->value == new_value))
+        {
+            this->value = std::forward<U>(new_value);
+            if constexpr (detail::is_atomic_readable<Type>)
+            {
+                if (this->atomic_value)
+                {
+                    this->atomic_value->store(this->value);
+                }
+            }
+
+            if (notify)
+            {
+                this->notify_updated();
+            }
+        }
+    }
 };
 }
 }
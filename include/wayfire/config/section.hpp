@@ -48,6 +48,20 @@ class section_t
      */
     option_list_t get_registered_options() const;
 
+    /**
+     * @return A list of the options whose name begins with @prefix, sorted by
+     *   name. The cost depends only on the number of matching options.
+     */
+    option_list_t get_options_with_prefix(const std::string& prefix) const;
+
+    /**
+     * @return A list of the options whose name matches the shell-style
+     *   pattern @pattern (see fnmatch(3)), for example "command_*", sorted by
+     *   name. Only the options whose name begins with the part of @pattern
+     *   before the first wildcard are tested.
+     */
+    option_list_t find_options(const std::string& pattern) const;
+
     /**
      * Register a new option, which means it is marked as belonging to this
      * section and it will show up in the list of get_registered_options().
@@ -62,6 +76,16 @@ class section_t
      */
     void unregister_option(std::shared_ptr<option_base_t> option);
 
+    /**
+     * Store the options in a sorted array instead of a tree, which makes
+     * lookups and iteration faster. Registering or unregistering an option
+     * afterwards automatically undoes this.
+     */
+    void freeze();
+
+    /** @return Whether the section is frozen, see freeze(). */
+    bool is_frozen() const;
+
     struct impl;
     std::unique_ptr<impl> priv;
 };
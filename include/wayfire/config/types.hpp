@@ -130,6 +130,9 @@ stdx::optional<color_t> from_string(const std::string& value);
 /** Convert the color to its hex string representation. */
 template<>
 std::string to_string(const color_t& value);
+
+template<>
+void append_to(std::string& out, const color_t& value);
 }
 
 /**
@@ -199,6 +202,9 @@ stdx::optional<keybinding_t> from_string(
 /** Represent the keybinding as a string. */
 template<>
 std::string to_string(const keybinding_t& value);
+
+template<>
+void append_to(std::string& out, const keybinding_t& value);
 }
 
 /**
@@ -245,6 +251,9 @@ stdx::optional<buttonbinding_t> from_string(
 /** Represent the buttonbinding as a string. */
 template<>
 std::string to_string(const buttonbinding_t& value);
+
+template<>
+void append_to(std::string& out, const buttonbinding_t& value);
 }
 
 /**
@@ -340,6 +349,9 @@ stdx::optional<touchgesture_t> from_string(
 /** Represent the touch gesture as a string. */
 template<>
 std::string to_string(const touchgesture_t& value);
+
+template<>
+void append_to(std::string& out, const touchgesture_t& value);
 }
 
 /**
@@ -409,6 +421,9 @@ stdx::optional<hotspot_binding_t> from_string(
 /** Represent the hotspot binding as a string. */
 template<>
 std::string to_string(const hotspot_binding_t& value);
+
+template<>
+void append_to(std::string& out, const hotspot_binding_t& value);
 }
 
 /**
@@ -430,6 +445,11 @@ struct activatorbinding_t
     /* Copy assignment */
     activatorbinding_t& operator =(const activatorbinding_t& other);
 
+    /* Move constructor, leaves @other as an empty binding */
+    activatorbinding_t(activatorbinding_t&& other) noexcept;
+    /* Move assignment, leaves @other as an empty binding */
+    activatorbinding_t& operator =(activatorbinding_t&& other) noexcept;
+
     /** @return true if the activator is activated by the given keybinding. */
     bool has_match(const keybinding_t& key) const;
 
@@ -471,6 +491,9 @@ stdx::optional<activatorbinding_t> from_string(
 /** Represent the activator binding as a string. */
 template<>
 std::string to_string(const activatorbinding_t& value);
+
+template<>
+void append_to(std::string& out, const activatorbinding_t& value);
 }
 
 /**
@@ -594,6 +617,9 @@ stdx::optional<output_config::mode_t> from_string(
 template<>
 std::string to_string(const output_config::mode_t& value);
 
+template<>
+void append_to(std::string& out, const output_config::mode_t& value);
+
 /**
  * Create an output position from its string description.
  * The supported formats are:
@@ -608,5 +634,8 @@ stdx::optional<output_config::position_t> from_string(
 /** Represent the activator binding as a string. */
 template<>
 std::string to_string(const output_config::position_t& value);
+
+template<>
+void append_to(std::string& out, const output_config::position_t& value);
 }
 }
@@ -50,6 +50,20 @@ std::shared_ptr<wf::config::option_base_t> create_option_from_xml_node(
  */
 std::shared_ptr<wf::config::section_t> create_section_from_xml_node(xmlNodePtr node);
 
+/**
+ * Read the first plugin or object element of the given XML file and create a
+ * section with its options, the same way create_section_from_xml_node() would.
+ * Errors are printed to the log (see wayfire/util/log.hpp).
+ *
+ * The file is streamed and no document tree is kept, so the resulting section
+ * and options are not associated with any XML node.
+ *
+ * @return nullptr if the file could not be parsed or does not contain a valid
+ *   section, and the generated config section otherwise.
+ */
+std::shared_ptr<wf::config::section_t> load_section_from_file(
+    const std::string& file);
+
 /**
  * Get the XML node which was used to create @option with
  * create_option_from_xml_node.
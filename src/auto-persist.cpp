@@ -0,0 +1,151 @@
+#include "auto-persist.hpp"
+#include <wayfire/config/file.hpp>
+
+wf::config::auto_persist_t::auto_persist_t(const std::string& file,
+    std::chrono::milliseconds interval) : file(file), interval(interval)
+{
+    this->writer = std::thread([this] { run(); });
+}
+
+wf::config::auto_persist_t::~auto_persist_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    cond.notify_all();
+    writer.join();
+
+    for (auto& [_, watch] : watched)
+    {
+        watch->option->rem_updated_handler(&watch->on_updated);
+    }
+}
+
+void wf::config::auto_persist_t::watch_section(
+    const std::shared_ptr<section_t>& section)
+{
+    auto name = section->get_name();
+    for (auto& option : section->get_registered_options())
+    {
+        queue_option(name, *option, false);
+        if (watched.count(option.get()))
+        {
+            continue;
+        }
+
+        auto watch = std::make_unique<watched_option_t>();
+        watch->option     = option;
+        watch->on_updated = [this, name, opt = option.get()] ()
+        {
+            queue_option(name, *opt, true);
+        };
+
+        option->add_updated_handler(&watch->on_updated);
+        watched[option.get()] = std::move(watch);
+    }
+}
+
+void wf::config::auto_persist_t::queue_option(const std::string& section_name,
+    const option_base_t& option, bool changed)
+{
+    auto clone = option.clone_option();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& section = pending[section_name];
+    if (!section)
+    {
+        section = std::make_shared<section_t>(section_name);
+    }
+
+    section->register_new_option(clone);
+    if (changed)
+    {
+        mark_changed();
+    }
+}
+
+void wf::config::auto_persist_t::mark_changed()
+{
+    if (changes == saved)
+    {
+        dirty_since = clock::now();
+    }
+
+    ++changes;
+    cond.notify_all();
+}
+
+void wf::config::auto_persist_t::forget_section(
+    const std::shared_ptr<section_t>& section)
+{
+    for (auto& option : section->get_registered_options())
+    {
+        auto it = watched.find(option.get());
+        if (it != watched.end())
+        {
+            option->rem_updated_handler(&it->second->on_updated);
+            watched.erase(it);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.erase(section->get_name());
+    removed.insert(section->get_name());
+    mark_changed();
+}
+
+void wf::config::auto_persist_t::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t target = changes;
+    flush_requested = std::max(flush_requested, target);
+    cond.notify_all();
+    cond.wait(lock, [&] { return saved >= target; });
+}
+
+void wf::config::auto_persist_t::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        cond.wait(lock, [&] { return (changes > saved) || stopping; });
+        if (changes == saved)
+        {
+            break;
+        }
+
+        /* Coalesce changes until the interval has passed both since the first
+         * unsaved change and since the last save. */
+        auto deadline = std::max(dirty_since, last_save) + interval;
+        cond.wait_until(lock, deadline, [&]
+        {
+            return stopping || (flush_requested > saved);
+        });
+
+        uint64_t target = changes;
+        auto sections   = std::move(pending);
+        auto to_remove  = std::move(removed);
+        pending.clear();
+        removed.clear();
+        lock.unlock();
+
+        for (auto& name : to_remove)
+        {
+            snapshot.remove_section(name);
+        }
+
+        for (auto& [_, section] : sections)
+        {
+            snapshot.merge_section(section);
+        }
+
+        save_configuration_to_file(snapshot, file);
+
+        lock.lock();
+        last_save = clock::now();
+        saved     = target;
+        cond.notify_all();
+    }
+}
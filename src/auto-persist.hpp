@@ -0,0 +1,85 @@
+#pragma once
+
+#include <wayfire/config/config-manager.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace wf
+{
+namespace config
+{
+/**
+ * Saves a configuration to a file from a background thread.
+ *
+ * The background thread works on its own copy of the configuration. Whenever
+ * a watched option changes, a clone of it is queued on the thread where the
+ * change happened, so the original options are never accessed from the
+ * background thread.
+ */
+class auto_persist_t
+{
+  public:
+    auto_persist_t(const std::string& file, std::chrono::milliseconds interval);
+
+    /** Save any pending changes and stop the background thread. */
+    ~auto_persist_t();
+
+    /**
+     * Add the current state of @section to the saved configuration, and
+     * start watching its options for changes.
+     */
+    void watch_section(const std::shared_ptr<section_t>& section);
+
+    /**
+     * Stop watching the options of @section, and remove it from the saved
+     * configuration.
+     */
+    void forget_section(const std::shared_ptr<section_t>& section);
+
+    /** Block until all changes so far have been saved. */
+    void flush();
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct watched_option_t
+    {
+        std::shared_ptr<option_base_t> option;
+        option_base_t::updated_callback_t on_updated;
+    };
+
+    /* Accessed only from the thread which owns the config manager */
+    std::map<option_base_t*, std::unique_ptr<watched_option_t>> watched;
+
+    /* Accessed only from the background thread */
+    config_manager_t snapshot;
+    const std::string file;
+    const clock::duration interval;
+    clock::time_point last_save;
+
+    /* Guarded by mutex */
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::map<std::string, std::shared_ptr<section_t>> pending;
+    std::set<std::string> removed;
+    uint64_t changes = 0;
+    uint64_t saved   = 0;
+    uint64_t flush_requested = 0;
+    clock::time_point dirty_since;
+    bool stopping = false;
+
+    std::thread writer;
+
+    /** Queue a clone of @option, and schedule a save if @changed. */
+    void queue_option(const std::string& section_name,
+        const option_base_t& option, bool changed);
+    /** Schedule a save. Must be called with the mutex locked. */
+    void mark_changed();
+    void run();
+};
+}
+}
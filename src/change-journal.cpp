@@ -0,0 +1,226 @@
+#include <wayfire/config/change-journal.hpp>
+#include <wayfire/config/compound-option.hpp>
+#include <wayfire/util/log.hpp>
+#include <algorithm>
+#include <map>
+
+struct wf::config::change_journal_t::impl
+{
+    struct watched_option_t
+    {
+        std::shared_ptr<option_base_t> option;
+        /* The last known value, which is the old value of the next change */
+        std::string value;
+        option_base_t::updated_callback_t on_updated;
+    };
+
+    struct change_t
+    {
+        uint32_t option;
+        uint64_t transaction;
+        std::string old_value;
+        std::string new_value;
+    };
+
+    std::vector<std::unique_ptr<watched_option_t>> options;
+    std::map<option_base_t*, uint32_t> option_ids;
+
+    /* A ring buffer of changes, starting at @first. The first @applied changes
+     * are done, the rest can be redone. */
+    std::vector<change_t> changes;
+    size_t capacity;
+    size_t first   = 0;
+    size_t count   = 0;
+    size_t applied = 0;
+
+    uint64_t next_transaction = 0;
+    uint64_t current_transaction = 0;
+    int transaction_depth = 0;
+    /* Set when the current transaction did not fit in the journal */
+    bool transaction_dropped = false;
+
+    /* Set while undoing or redoing, so that the changes are not recorded */
+    bool replaying = false;
+
+    change_t& at(size_t index)
+    {
+        return changes[(first + index) % capacity];
+    }
+
+    void record(uint32_t id)
+    {
+        auto& watched = *options[id];
+        auto new_value = watched.option->get_value_str();
+        if (replaying || (new_value == watched.value) ||
+            ((transaction_depth > 0) && transaction_dropped))
+        {
+            watched.value = std::move(new_value);
+            return;
+        }
+
+        /* Recording a new change makes undone changes unreachable */
+        count = applied;
+        if (count == capacity)
+        {
+            /* The changes are ordered by transaction, so if the oldest change
+             * belongs to the current transaction, all of them do. The
+             * transaction cannot be undone as a whole, and the transactions
+             * before it cannot be undone without it. */
+            if ((transaction_depth > 0) &&
+                (at(0).transaction == current_transaction))
+            {
+                LOGW("A transaction has more than ", capacity,
+                    " changes, dropping the undo history");
+                first   = 0;
+                count   = 0;
+                applied = 0;
+                transaction_dropped = true;
+                watched.value = std::move(new_value);
+                return;
+            }
+
+            /* Forget the oldest transaction */
+            uint64_t oldest = at(0).transaction;
+            while (count > 0 && at(0).transaction == oldest)
+            {
+                first = (first + 1) % capacity;
+                --count;
+            }
+
+            applied = count;
+        }
+
+        uint64_t transaction =
+            transaction_depth > 0 ? current_transaction : next_transaction++;
+        change_t change{id, transaction, std::move(watched.value), new_value};
+        size_t index = (first + count) % capacity;
+        if (index < changes.size())
+        {
+            changes[index] = std::move(change);
+        } else
+        {
+            changes.push_back(std::move(change));
+        }
+
+        ++count;
+        applied = count;
+        watched.value = std::move(new_value);
+    }
+
+    void apply(const change_t& change, const std::string& value)
+    {
+        replaying = true;
+        options[change.option]->option->set_value_str(value);
+        replaying = false;
+    }
+};
+
+wf::config::change_journal_t::change_journal_t(config_manager_t& manager,
+    size_t capacity)
+{
+    this->priv = std::make_unique<impl>();
+    this->priv->capacity = std::max<size_t>(capacity, 1);
+    for (auto& section : manager.get_all_sections())
+    {
+        watch_section(section);
+    }
+}
+
+wf::config::change_journal_t::~change_journal_t()
+{
+    for (auto& watched : priv->options)
+    {
+        watched->option->rem_updated_handler(&watched->on_updated);
+    }
+}
+
+void wf::config::change_journal_t::watch_section(
+    const std::shared_ptr<section_t>& section)
+{
+    for (auto& option : section->get_registered_options())
+    {
+        if (std::dynamic_pointer_cast<compound_option_t>(option) ||
+            priv->option_ids.count(option.get()))
+        {
+            continue;
+        }
+
+        uint32_t id = priv->options.size();
+        auto watched    = std::make_unique<impl::watched_option_t>();
+        watched->option = option;
+        watched->value  = option->get_value_str();
+        watched->on_updated = [this, id] () { priv->record(id); };
+        option->add_updated_handler(&watched->on_updated);
+
+        priv->option_ids[option.get()] = id;
+        priv->options.push_back(std::move(watched));
+    }
+}
+
+void wf::config::change_journal_t::begin_transaction()
+{
+    if (priv->transaction_depth++ == 0)
+    {
+        priv->current_transaction = priv->next_transaction++;
+        priv->transaction_dropped = false;
+    }
+}
+
+void wf::config::change_journal_t::end_transaction()
+{
+    priv->transaction_depth = std::max(priv->transaction_depth - 1, 0);
+}
+
+bool wf::config::change_journal_t::can_undo() const
+{
+    return priv->applied > 0;
+}
+
+bool wf::config::change_journal_t::can_redo() const
+{
+    return priv->applied < priv->count;
+}
+
+bool wf::config::change_journal_t::undo()
+{
+    if (!can_undo())
+    {
+        return false;
+    }
+
+    uint64_t transaction = priv->at(priv->applied - 1).transaction;
+    while (priv->applied > 0 &&
+           priv->at(priv->applied - 1).transaction == transaction)
+    {
+        auto& change = priv->at(--priv->applied);
+        priv->apply(change, change.old_value);
+    }
+
+    return true;
+}
+
+bool wf::config::change_journal_t::redo()
+{
+    if (!can_redo())
+    {
+        return false;
+    }
+
+    uint64_t transaction = priv->at(priv->applied).transaction;
+    while (priv->applied < priv->count &&
+           priv->at(priv->applied).transaction == transaction)
+    {
+        auto& change = priv->at(priv->applied++);
+        priv->apply(change, change.new_value);
+    }
+
+    return true;
+}
+
+void wf::config::change_journal_t::clear()
+{
+    priv->changes.clear();
+    priv->first   = 0;
+    priv->count   = 0;
+    priv->applied = 0;
+}
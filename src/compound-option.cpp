@@ -1,14 +1,9 @@
 #include <wayfire/config/compound-option.hpp>
-#include <wayfire/config/xml.hpp>
 #include "option-impl.hpp"
+#include <typeinfo>
 
 using namespace wf::config;
 
-static bool begins_with(const std::string& a, const std::string& b)
-{
-    return a.substr(0, b.size()) == b;
-}
-
 compound_option_t::compound_option_t(const std::string& name,
     entries_t&& entries, std::string type_hint) : option_base_t(name),
     list_type_hint(
@@ -21,111 +16,131 @@ void wf::config::update_compound_from_section(
     compound_option_t& compound,
     const std::shared_ptr<section_t>& section)
 {
-    auto options = section->get_registered_options();
-    std::vector<std::vector<std::string>> new_value;
-
     struct tuple_in_construction_t
     {
-        // How many of the tuple elements were initialized
-        size_t initialized = 0;
         std::vector<std::string> values;
+        // The parsed values of values[1..]
+        std::vector<std::any> cells;
     };
 
-    std::map<std::string, std::vector<std::string>> new_values;
+    std::map<std::string, tuple_in_construction_t> new_values;
     const auto& entries = compound.get_entries();
 
     for (size_t n = 0; n < entries.size(); n++)
     {
         const auto& prefix = entries[n]->get_prefix();
-        for (auto& opt : options)
+        for (auto& opt : section->get_options_with_prefix(prefix))
         {
-            if (xml::get_option_xml_node(opt) ||
+            if (opt->priv->declared_in_xml ||
                 !opt->priv->option_in_config_file)
             {
                 continue;
             }
 
-            if (begins_with(opt->get_name(), prefix))
+            // Find the suffix we should store values in.
+            std::string suffix = opt->get_name().substr(prefix.size());
+            if (!new_values.count(suffix) && (n > 0))
+            {
+                // Skip entries which did not have their first value set,
+                // because these will not be fully constructed in the end.
+                continue;
+            }
+
+            auto& tuple = new_values[suffix];
+
+            // Parse the value from the option, with the n-th type.
+            auto value_str = opt->get_value_str();
+            std::any cell;
+            if (!entries[n]->parse(value_str, cell))
             {
-                // We have found a match.
-                // Find the suffix we should store values in.
-                std::string suffix = opt->get_name().substr(prefix.size());
-                if (!new_values.count(suffix) && (n > 0))
-                {
-                    // Skip entries which did not have their first value set,
-                    // because these will not be fully constructed in the end.
-                    continue;
-                }
-
-                auto& tuple = new_values[suffix];
-
-                // Parse the value from the option, with the n-th type.
-                if (!entries[n]->is_parsable(opt->get_value_str()))
-                {
-                    LOGE("Failed parsing option ",
-                        section->get_name() + "/" + opt->get_name(),
-                        " as part of the list option ",
-                        section->get_name() + "/" + compound.get_name());
-                    new_values.erase(suffix);
-                    continue;
-                }
-
-                if (n == 0)
-                {
-                    // Push the suffix first
-                    tuple.push_back(suffix);
-                }
-
-                // Update the Nth entry in the tuple (+1 because the first entry
-                // is the amount of initialized entries).
-                tuple.push_back(opt->get_value_str());
+                LOGE("Failed parsing option ",
+                    section->get_name() + "/" + opt->get_name(),
+                    " as part of the list option ",
+                    section->get_name() + "/" + compound.get_name());
+                new_values.erase(suffix);
+                continue;
             }
+
+            if (n == 0)
+            {
+                // Push the suffix first
+                tuple.values.push_back(suffix);
+            }
+
+            // Update the Nth entry in the tuple (+1 because the first entry
+            // is the suffix).
+            tuple.values.push_back(std::move(value_str));
+            tuple.cells.push_back(std::move(cell));
         }
     }
 
     compound_option_t::stored_type_t value;
+    std::vector<std::vector<std::any>> cells;
     for (auto& e : new_values)
     {
         // Ignore entires which do not have all entries set
-        if (e.second.size() != entries.size() + 1)
+        if (e.second.values.size() != entries.size() + 1)
         {
             continue;
         }
 
-        value.push_back(std::move(e.second));
+        value.push_back(std::move(e.second.values));
+        cells.push_back(std::move(e.second.cells));
     }
 
-    compound.set_value_untyped(value);
+    compound.set_parsed_value(std::move(value), std::move(cells));
 }
 
-compound_option_t::stored_type_t compound_option_t::get_value_untyped()
+const compound_option_t::stored_type_t& compound_option_t::get_value_untyped() const
 {
     return this->value;
 }
 
 bool compound_option_t::set_value_untyped(stored_type_t value)
 {
-    for (auto& e : value)
+    std::vector<std::vector<std::any>> new_cells(value.size());
+    for (size_t j = 0; j < value.size(); j++)
     {
+        auto& e = value[j];
         if (e.size() != this->entries.size() + 1)
         {
             return false;
         }
 
+        new_cells[j].resize(this->entries.size());
         for (size_t i = 1; i <= this->entries.size(); i++)
         {
-            if (!entries[i - 1]->is_parsable(e[i]))
+            if (!entries[i - 1]->parse(e[i], new_cells[j][i - 1]))
             {
                 return false;
             }
         }
     }
 
-    this->value = value;
-    notify_updated();
+    set_parsed_value(std::move(value), std::move(new_cells));
     return true;
 }
 
+void compound_option_t::set_parsed_value(stored_type_t&& value,
+    std::vector<std::vector<std::any>>&& cells)
+{
+    this->value.swap(value);
+    this->cells.swap(cells);
+    rebuild_key_index();
+    notify_updated();
+}
+
+void compound_option_t::rebuild_key_index()
+{
+    key_index.clear();
+    key_index.reserve(value.size());
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        // Keeps the first tuple if a key is repeated
+        key_index.emplace(value[i][0], i);
+    }
+}
+
 const compound_option_t::entries_t& compound_option_t::get_entries() const
 {
     return this->entries;
@@ -141,8 +156,12 @@ std::shared_ptr<option_base_t> compound_option_t::clone_option() const
             std::unique_ptr<compound_option_entry_base_t>(e->clone()));
     }
 
-    auto result = std::make_shared<compound_option_t>(get_name(), std::move(cloned));
+    auto result = std::make_shared<compound_option_t>(get_name(),
+        std::move(cloned), this->list_type_hint);
     result->value = this->value;
+    result->cells = this->cells;
+    result->key_index = this->key_index;
+    init_clone(*result);
     return result;
 }
 
@@ -155,6 +174,8 @@ bool wf::config::compound_option_t::set_value_str(const std::string&)
 void wf::config::compound_option_t::reset_to_default()
 {
     this->value.clear();
+    this->cells.clear();
+    this->key_index.clear();
 }
 
 bool wf::config::compound_option_t::set_default_value_str(const std::string&)
@@ -174,3 +195,27 @@ std::string wf::config::compound_option_t::get_default_value_str() const
     // XXX: not supported yet
     return "";
 }
+
+bool wf::config::compound_option_t::assign_from(const option_base_t& other)
+{
+    auto compound = dynamic_cast<const compound_option_t*>(&other);
+    if (!compound || (compound->entries.size() != this->entries.size()))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const auto& ours   = *this->entries[i];
+        const auto& theirs = *compound->entries[i];
+        if (typeid(ours) != typeid(theirs))
+        {
+            return false;
+        }
+    }
+
+    auto new_value = compound->value;
+    auto new_cells = compound->cells;
+    set_parsed_value(std::move(new_value), std::move(new_cells));
+    return true;
+}
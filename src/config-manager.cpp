@@ -1,26 +1,173 @@
 #include <wayfire/config/config-manager.hpp>
+#include <wayfire/util/log.hpp>
+#include <algorithm>
 #include <cassert>
 #include <map>
+#include <utility>
+
+#include "auto-persist.hpp"
+#include "flat-map.hpp"
+#include "name-index.hpp"
+#include "notification-queue.hpp"
+#include "option-id-table.hpp"
 
 struct wf::config::config_manager_t::impl
 {
     std::map<std::string, std::shared_ptr<section_t>> sections;
+    std::map<std::string, std::vector<section_loader_t>> loaders;
+
+    /* Replaces @sections while the config manager is frozen */
+    flat_map_t<std::shared_ptr<section_t>> frozen_sections;
+    bool frozen = false;
+
+    /* Sections of the form [type:name], by type */
+    std::map<std::string, std::vector<std::shared_ptr<section_t>>> instances;
+    std::map<std::string, std::vector<instance_callback_t*>> instance_handlers;
+
+    std::unique_ptr<notification_queue_t> notifications;
+
+    option_id_table_t option_ids;
+    /* Whether merged sections get IDs, see assign_option_ids() */
+    bool assigns_ids = false;
+
+    /* Declared last, so that it is destroyed before the sections */
+    std::unique_ptr<auto_persist_t> persist;
+
+    /** Call @callback with the container which currently holds the sections. */
+    template<class Callback>
+    auto with_sections(Callback&& callback) const
+    {
+        return frozen ? callback(frozen_sections) : callback(sections);
+    }
+
+    /** Move the sections back to @sections, so that they can be modified. */
+    void thaw()
+    {
+        if (frozen)
+        {
+            sections = {frozen_sections.begin(), frozen_sections.end()};
+            frozen_sections = {};
+            frozen = false;
+        }
+    }
+
+    /** Run and remove the loaders for the section with the given name. */
+    void run_loaders(config_manager_t& self, const std::string& name)
+    {
+        auto it = loaders.find(name);
+        if (it == loaders.end())
+        {
+            return;
+        }
+
+        /* Remove the loaders first, merge_section() comes back here. */
+        auto pending = std::move(it->second);
+        loaders.erase(it);
+        for (auto& loader : pending)
+        {
+            if (auto section = loader())
+            {
+                self.merge_section(section);
+            }
+        }
+    }
+
+    /**
+     * @return The object type of the section with the given name, or an empty
+     *   string if the section is not an object instance.
+     */
+    static std::string get_object_type(const std::string& name)
+    {
+        size_t splitter = name.find_first_of(":");
+        if ((splitter == std::string::npos) || (splitter == 0) ||
+            (splitter + 1 == name.size()))
+        {
+            return "";
+        }
+
+        return name.substr(0, splitter);
+    }
+
+    void update_instances(const std::shared_ptr<section_t>& section, bool added)
+    {
+        auto type = get_object_type(section->get_name());
+        if (type.empty())
+        {
+            return;
+        }
+
+        auto& list = instances[type];
+        if (added)
+        {
+            list.push_back(section);
+        } else
+        {
+            list.erase(std::remove(list.begin(), list.end(), section), list.end());
+        }
+
+        auto it = instance_handlers.find(type);
+        if (it != instance_handlers.end())
+        {
+            auto to_call = it->second;
+            for (auto& call : to_call)
+            {
+                (*call)(section, added);
+            }
+        }
+    }
 };
 
+void wf::config::config_manager_t::add_section_loader(const std::string& name,
+    section_loader_t loader)
+{
+    this->priv->loaders[name].push_back(std::move(loader));
+}
+
+void wf::config::config_manager_t::load_all_sections()
+{
+    while (!this->priv->loaders.empty())
+    {
+        this->priv->run_loaders(*this, this->priv->loaders.begin()->first);
+    }
+}
+
 void wf::config::config_manager_t::merge_section(
     std::shared_ptr<section_t> section)
 {
     assert(section);
-    if (this->priv->sections.count(section->get_name()) == 0)
+    this->priv->run_loaders(*this, section->get_name());
+    auto existing_section = this->priv->with_sections([&] (auto& sections)
+    {
+        auto it = sections.find(section->get_name());
+        return (it == sections.end()) ? nullptr : it->second;
+    });
+
+    if (!existing_section)
     {
         /* Did not exist previously, just add the new section */
+        this->priv->thaw();
         this->priv->sections[section->get_name()] = section;
+        if (this->priv->persist)
+        {
+            this->priv->persist->watch_section(section);
+        }
+
+        if (this->priv->notifications)
+        {
+            this->priv->notifications->watch_section(section);
+        }
+
+        if (this->priv->assigns_ids)
+        {
+            this->priv->option_ids.assign(*section);
+        }
+
+        this->priv->update_instances(section, true);
         return;
     }
 
     /* Merge with existing config section */
-    auto existing_section = get_section(section->get_name());
-    auto merging_options  = section->get_registered_options();
+    auto merging_options = section->get_registered_options();
     for (auto& option : merging_options)
     {
         auto existing_option =
@@ -28,39 +175,333 @@ void wf::config::config_manager_t::merge_section(
 
         if (existing_option)
         {
-            existing_option->set_value_str(option->get_value_str());
+            if (!existing_option->assign_from(*option))
+            {
+                existing_option->set_value_str(option->get_value_str());
+            }
         } else
         {
             existing_section->register_new_option(option);
         }
     }
+
+    if (this->priv->assigns_ids)
+    {
+        this->priv->option_ids.assign(*existing_section);
+    }
+
+    if (this->priv->persist)
+    {
+        this->priv->persist->watch_section(existing_section);
+    }
+
+    if (this->priv->notifications)
+    {
+        this->priv->notifications->watch_section(existing_section);
+    }
+}
+
+void wf::config::config_manager_t::enable_auto_persist(const std::string& file,
+    std::chrono::milliseconds interval)
+{
+    disable_auto_persist();
+    this->priv->persist = std::make_unique<auto_persist_t>(file, interval);
+    for (auto& section : get_all_sections())
+    {
+        this->priv->persist->watch_section(section);
+    }
+}
+
+void wf::config::config_manager_t::disable_auto_persist()
+{
+    this->priv->persist.reset();
+}
+
+void wf::config::config_manager_t::flush_auto_persist()
+{
+    if (this->priv->persist)
+    {
+        this->priv->persist->flush();
+    }
+}
+
+int wf::config::config_manager_t::enable_notification_queue()
+{
+    disable_notification_queue();
+    this->priv->notifications = std::make_unique<notification_queue_t>();
+    for (auto& section : get_all_sections())
+    {
+        this->priv->notifications->watch_section(section);
+    }
+
+    return this->priv->notifications->get_fd();
+}
+
+void wf::config::config_manager_t::disable_notification_queue()
+{
+    if (this->priv->notifications)
+    {
+        this->priv->notifications->dispatch();
+        this->priv->notifications.reset();
+    }
+}
+
+void wf::config::config_manager_t::dispatch_notifications()
+{
+    if (this->priv->notifications)
+    {
+        this->priv->notifications->dispatch();
+    }
+}
+
+void wf::config::config_manager_t::log_notification_profile() const
+{
+    using profile_t = option_base_t::handler_profile_t;
+    std::vector<std::pair<std::string, profile_t>> entries;
+    for (auto& section : get_all_sections())
+    {
+        for (auto& option : section->get_registered_options())
+        {
+            for (auto& profile : option->get_handler_profile())
+            {
+                entries.push_back({section->get_name() + "/" + option->get_name(),
+                    profile});
+            }
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(),
+        [] (const auto& a, const auto& b)
+    {
+        return a.second.total > b.second.total;
+    });
+
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+    LOGI("Updated handler profile (", entries.size(), " handlers):");
+    for (auto& [name, profile] : entries)
+    {
+        LOGI(name, " handler ", (void*)profile.handler, ": ", profile.calls,
+            " calls, total ", duration_cast<microseconds>(profile.total).count(),
+            "us, max ", duration_cast<microseconds>(profile.max).count(), "us");
+    }
+}
+
+std::shared_ptr<wf::config::section_t> wf::config::config_manager_t::get_section(
+    const std::string& name)
+{
+    this->priv->run_loaders(*this, name);
+    return std::as_const(*this).get_section(name);
 }
 
 std::shared_ptr<wf::config::section_t> wf::config::config_manager_t::get_section(
     const std::string& name) const
 {
-    if (this->priv->sections.count(name))
+    return this->priv->with_sections([&] (auto& sections)
     {
-        return this->priv->sections.at(name);
+        auto it = sections.find(name);
+        return (it == sections.end()) ? nullptr : it->second;
+    });
+}
+
+void wf::config::config_manager_t::remove_section(const std::string& name)
+{
+    this->priv->loaders.erase(name);
+    this->priv->thaw();
+    auto it = this->priv->sections.find(name);
+    if (it == this->priv->sections.end())
+    {
+        return;
     }
 
-    return nullptr;
+    auto section = it->second;
+    this->priv->sections.erase(it);
+    if (this->priv->persist)
+    {
+        this->priv->persist->forget_section(section);
+    }
+
+    if (this->priv->notifications)
+    {
+        this->priv->notifications->forget_section(section);
+    }
+
+    for (auto& option : section->get_registered_options())
+    {
+        this->priv->option_ids.remove(*option);
+    }
+
+    this->priv->update_instances(section, false);
+}
+
+void wf::config::config_manager_t::freeze()
+{
+    for (auto& section : get_all_sections())
+    {
+        section->freeze();
+    }
+
+    if (!this->priv->frozen)
+    {
+        this->priv->frozen_sections =
+            decltype(this->priv->frozen_sections){this->priv->sections};
+        this->priv->sections.clear();
+        this->priv->frozen = true;
+    }
+}
+
+bool wf::config::config_manager_t::is_frozen() const
+{
+    return this->priv->frozen;
+}
+
+size_t wf::config::config_manager_t::assign_option_ids()
+{
+    this->priv->assigns_ids = true;
+    for (auto& section : get_all_sections())
+    {
+        this->priv->option_ids.assign(*section);
+    }
+
+    return this->priv->option_ids.size();
+}
+
+wf::config::config_manager_t::option_id_t wf::config::config_manager_t::
+get_option_id(const std::string& name)
+{
+    /* Load the section first, merging assigns IDs to its options */
+    get_option(name);
+    return std::as_const(*this).get_option_id(name);
+}
+
+wf::config::config_manager_t::option_id_t wf::config::config_manager_t::
+get_option_id(const std::string& name) const
+{
+    auto option = get_option(name);
+    return option ? this->priv->option_ids.find(*option) : INVALID_OPTION_ID;
+}
+
+wf::config::option_base_t *wf::config::config_manager_t::get_option_by_id(
+    option_id_t id) const
+{
+    return this->priv->option_ids.get(id);
+}
+
+const std::vector<std::shared_ptr<wf::config::section_t>>& wf::config::
+config_manager_t::get_object_instances(const std::string& type) const
+{
+    static const std::vector<std::shared_ptr<section_t>> none;
+    auto it = this->priv->instances.find(type);
+    return (it == this->priv->instances.end()) ? none : it->second;
+}
+
+void wf::config::config_manager_t::add_instance_handler(const std::string& type,
+    instance_callback_t *callback)
+{
+    this->priv->instance_handlers[type].push_back(callback);
+}
+
+void wf::config::config_manager_t::rem_instance_handler(const std::string& type,
+    instance_callback_t *callback)
+{
+    auto& list = this->priv->instance_handlers[type];
+    list.erase(std::remove(list.begin(), list.end(), callback), list.end());
 }
 
 std::vector<std::shared_ptr<wf::config::section_t>> wf::config::config_manager_t::
 get_all_sections() const
 {
     std::vector<std::shared_ptr<wf::config::section_t>> list;
-    for (auto& section : this->priv->sections)
+    this->priv->with_sections([&] (auto& sections)
+    {
+        list.reserve(sections.size());
+        for (auto& section : sections)
+        {
+            list.push_back(section.second);
+        }
+    });
+
+    return list;
+}
+
+std::vector<std::shared_ptr<wf::config::section_t>> wf::config::config_manager_t::
+find_sections(const std::string& pattern)
+{
+    std::vector<std::string> to_load;
+    for_each_matching(priv->loaders, pattern, [&] (auto& loader)
+    {
+        to_load.push_back(loader.first);
+    });
+
+    for (auto& name : to_load)
     {
-        list.push_back(section.second);
+        priv->run_loaders(*this, name);
     }
 
+    return std::as_const(*this).find_sections(pattern);
+}
+
+std::vector<std::shared_ptr<wf::config::section_t>> wf::config::config_manager_t::
+find_sections(const std::string& pattern) const
+{
+    std::vector<std::shared_ptr<section_t>> list;
+    priv->with_sections([&] (auto& sections)
+    {
+        for_each_matching(sections, pattern, [&] (auto& section)
+        {
+            list.push_back(section.second);
+        });
+    });
+
     return list;
 }
 
-std::shared_ptr<wf::config::option_base_t> wf::config::config_manager_t::get_option(
-    const std::string& name) const
+/**
+ * Find options by pattern in @manager, see config_manager_t::find_options().
+ * The sections are looked up with the const or non-const find_sections(),
+ * depending on @Manager.
+ */
+template<class Manager>
+static std::vector<std::shared_ptr<wf::config::option_base_t>> find_options_in(
+    Manager& manager, const std::string& pattern)
+{
+    std::vector<std::shared_ptr<wf::config::option_base_t>> list;
+    size_t splitter = pattern.find_first_of("/");
+    if (splitter == std::string::npos)
+    {
+        return list;
+    }
+
+    auto option_pattern = pattern.substr(splitter + 1);
+    for (auto& section : manager.find_sections(pattern.substr(0, splitter)))
+    {
+        auto options = section->find_options(option_pattern);
+        list.insert(list.end(), options.begin(), options.end());
+    }
+
+    return list;
+}
+
+std::vector<std::shared_ptr<wf::config::option_base_t>> wf::config::
+config_manager_t::find_options(const std::string& pattern)
+{
+    return find_options_in(*this, pattern);
+}
+
+std::vector<std::shared_ptr<wf::config::option_base_t>> wf::config::
+config_manager_t::find_options(const std::string& pattern) const
+{
+    return find_options_in(*this, pattern);
+}
+
+/**
+ * Find the option with the given full name in @manager, see
+ * config_manager_t::get_option(). The section is looked up with the const or
+ * non-const get_section(), depending on @Manager.
+ */
+template<class Manager>
+static std::shared_ptr<wf::config::option_base_t> get_option_in(
+    Manager& manager, const std::string& name)
 {
     size_t splitter = name.find_first_of("/");
     if (splitter == std::string::npos)
@@ -75,7 +516,7 @@ std::shared_ptr<wf::config::option_base_t> wf::config::config_manager_t::get_opt
         return nullptr;
     }
 
-    auto section_ptr = get_section(section_name);
+    auto section_ptr = manager.get_section(section_name);
     if (section_ptr)
     {
         return section_ptr->get_option_or(option_name);
@@ -84,6 +525,18 @@ std::shared_ptr<wf::config::option_base_t> wf::config::config_manager_t::get_opt
     return nullptr;
 }
 
+std::shared_ptr<wf::config::option_base_t> wf::config::config_manager_t::get_option(
+    const std::string& name)
+{
+    return get_option_in(*this, name);
+}
+
+std::shared_ptr<wf::config::option_base_t> wf::config::config_manager_t::get_option(
+    const std::string& name) const
+{
+    return get_option_in(*this, name);
+}
+
 wf::config::config_manager_t::config_manager_t()
 {
     this->priv = std::make_unique<impl>();
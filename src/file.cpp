@@ -7,12 +7,17 @@
 #include <fstream>
 #include <cassert>
 #include <set>
+#include <algorithm>
+#include <cstdlib>
 
 #include "option-impl.hpp"
 
 #include <sys/file.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <cerrno>
+#include <cstring>
 #include <dirent.h>
 
 class line_t : public std::string
@@ -99,68 +104,111 @@ line_t remove_escaped_sharps(const line_t& line)
     return result;
 }
 
-static lines_t remove_comments(const lines_t& lines)
+/**
+ * Remove the comment and the trailing whitespace from a single physical line.
+ */
+static line_t clean_line(const line_t& line)
 {
-    lines_t result;
-    for (const auto& line : lines)
+    auto pos    = find_first_nonescaped(line, '#');
+    auto result = remove_escaped_sharps(line.substr(0, pos));
+    while (!result.empty() && std::isspace(result.back()))
     {
-        auto pos = find_first_nonescaped(line, '#');
-        result.push_back(
-            remove_escaped_sharps(line.substr(0, pos)));
+        result.pop_back();
     }
 
     return result;
 }
 
-static lines_t remove_trailing_whitespace(const lines_t& lines)
+static lines_t clean_lines(const lines_t& lines)
 {
     lines_t result;
     for (const auto& line : lines)
     {
-        auto result_line = line;
-        while (!result_line.empty() && std::isspace(result_line.back()))
-        {
-            result_line.pop_back();
-        }
-
-        result.push_back(result_line);
+        result.push_back(clean_line(line));
     }
 
     return result;
 }
 
-lines_t join_lines(const lines_t& lines)
+/**
+ * Joins physical lines which end in a non-escaped '\' with the lines after
+ * them, one physical line at a time.
+ */
+class line_joiner_t
 {
-    lines_t result;
-    bool in_concat_mode = false;
-
-    for (const auto& line : lines)
+  public:
+    /**
+     * Add the next (cleaned) physical line.
+     *
+     * @return true if the line completes a logical line, available via get().
+     */
+    bool push(const line_t& line)
     {
         if (in_concat_mode)
         {
-            assert(!result.empty());
-            result.back() += line;
+            current += line;
         } else
         {
-            result.push_back(line);
+            current = line;
         }
 
-        if (result.empty() || result.back().empty())
+        if (current.empty())
         {
             in_concat_mode = false;
         } else
         {
-            in_concat_mode = (result.back().back() == '\\');
+            in_concat_mode = (current.back() == '\\');
             if (in_concat_mode) /* pop last \ */
             {
-                result.back().pop_back();
+                current.pop_back();
             }
 
             /* If last \ was escaped, we should ignore it */
-            bool was_escaped =
-                !result.back().empty() && result.back().back() == '\\';
+            bool was_escaped = !current.empty() && current.back() == '\\';
             in_concat_mode = in_concat_mode && !was_escaped;
         }
+
+        return !in_concat_mode;
+    }
+
+    /** Whether the last line ended with a continuation. */
+    bool pending() const
+    {
+        return in_concat_mode;
+    }
+
+    const line_t& get() const
+    {
+        return current;
+    }
+
+    void reset()
+    {
+        current.clear();
+        in_concat_mode = false;
+    }
+
+  private:
+    line_t current;
+    bool in_concat_mode = false;
+};
+
+lines_t join_lines(const lines_t& lines)
+{
+    lines_t result;
+    line_joiner_t joiner;
+    for (const auto& line : lines)
+    {
+        if (joiner.push(line))
+        {
+            result.push_back(joiner.get());
+        }
+    }
+
+    /* A continuation on the last line joins with nothing */
+    if (joiner.pending())
+    {
+        result.push_back(joiner.get());
     }
 
     return result;
@@ -212,6 +260,25 @@ enum option_parsing_result
     OPTION_PARSED_INVALID_CONTENTS,
 };
 
+/**
+ * Split an option line of the form <name> = <value>.
+ *
+ * @return false if the line does not contain a '=' sign.
+ */
+static bool split_option_line(const line_t& line, std::string& name,
+    std::string& value)
+{
+    size_t equal_sign = line.find_first_of("=");
+    if (equal_sign == std::string::npos)
+    {
+        return false;
+    }
+
+    name  = ignore_leading_trailing_whitespace(line.substr(0, equal_sign));
+    value = ignore_leading_trailing_whitespace(line.substr(equal_sign + 1));
+    return true;
+}
+
 /**
  * Try to parse an option line.
  * If the option line is valid, the corresponding option is modified or added
@@ -223,15 +290,12 @@ static option_parsing_result parse_option_line(
     wf::config::section_t& current_section, const line_t& line,
     std::set<std::shared_ptr<wf::config::option_base_t>>& reloaded)
 {
-    size_t equal_sign = line.find_first_of("=");
-    if (equal_sign == std::string::npos)
+    std::string name, value;
+    if (!split_option_line(line, name, value))
     {
         return OPTION_PARSED_WRONG_FORMAT;
     }
 
-    auto name  = ignore_leading_trailing_whitespace(line.substr(0, equal_sign));
-    auto value = ignore_leading_trailing_whitespace(line.substr(equal_sign + 1));
-
     auto option = current_section.get_option_or(name);
     if (!option)
     {
@@ -250,6 +314,22 @@ static option_parsing_result parse_option_line(
     return OPTION_PARSED_INVALID_CONTENTS;
 }
 
+/**
+ * Check whether the @line is a valid section start, and if yes, store the name
+ * of the section in @name.
+ */
+static bool parse_section_name(const line_t& line, std::string& name)
+{
+    auto trimmed = ignore_leading_trailing_whitespace(line);
+    if (trimmed.empty() || (trimmed.front() != '[') || (trimmed.back() != ']'))
+    {
+        return false;
+    }
+
+    name = trimmed.substr(1, trimmed.length() - 2);
+    return true;
+}
+
 /**
  * Check whether the @line is a valid section start.
  * If yes, it will either return the section in @config with the same name, or
@@ -260,14 +340,12 @@ static option_parsing_result parse_option_line(
 static std::shared_ptr<wf::config::section_t> check_section(
     wf::config::config_manager_t& config, const line_t& line)
 {
-    auto name = ignore_leading_trailing_whitespace(line);
-    if (name.empty() || (name.front() != '[') || (name.back() != ']'))
+    std::string real_name;
+    if (!parse_section_name(line, real_name))
     {
         return {};
     }
 
-    auto real_name = name.substr(1, name.length() - 2);
-
     auto section = config.get_section(real_name);
     if (!section)
     {
@@ -296,35 +374,63 @@ static std::shared_ptr<wf::config::section_t> check_section(
     return section;
 }
 
-void wf::config::load_configuration_options_from_string(
-    config_manager_t& config, const std::string& source,
-    const std::string& source_name)
+/**
+ * Split the source into logical lines, with comments, trailing whitespace and
+ * empty lines removed and continuation lines joined.
+ */
+static lines_t split_to_logical_lines(const std::string& source)
+{
+    return skip_empty(
+        join_lines(
+            clean_lines(
+                split_to_lines(source))));
+}
+
+struct wf::config::config_stream_parser_t::impl
 {
+    config_manager_t& config;
+    std::string source_name;
+
+    /* The physical line which has not been terminated by a newline yet */
+    line_t partial;
+    size_t line_idx = 1;
+    line_joiner_t joiner;
+
+    std::shared_ptr<section_t> current_section;
     std::set<std::shared_ptr<option_base_t>> reloaded;
 
-    auto lines =
-        skip_empty(
-            join_lines(
-                remove_trailing_whitespace(
-                    remove_comments(
-                        split_to_lines(source)))));
+    impl(config_manager_t& config, const std::string& source_name) :
+        config(config), source_name(source_name)
+    {}
 
-    std::shared_ptr<wf::config::section_t> current_section;
+    void push_physical_line(line_t&& line)
+    {
+        line.source_line_number = line_idx++;
+        if (joiner.push(clean_line(line)))
+        {
+            apply_line(joiner.get());
+        }
+    }
 
-    for (const auto& line : lines)
+    void apply_line(const line_t& line)
     {
+        if (line.empty())
+        {
+            return;
+        }
+
         auto next_section = check_section(config, line);
         if (next_section)
         {
             current_section = next_section;
-            continue;
+            return;
         }
 
         if (!current_section)
         {
             LOGE("Error in file ", source_name, ":", line.source_line_number,
                 ", option declared before a section starts!");
-            continue;
+            return;
         }
 
         auto status = parse_option_line(*current_section, line, reloaded);
@@ -345,6 +451,51 @@ void wf::config::load_configuration_options_from_string(
             break;
         }
     }
+};
+
+wf::config::config_stream_parser_t::config_stream_parser_t(
+    config_manager_t& manager, const std::string& source_name)
+{
+    this->priv = std::make_unique<impl>(manager, source_name);
+}
+
+wf::config::config_stream_parser_t::~config_stream_parser_t() = default;
+
+void wf::config::config_stream_parser_t::feed(const char *data, size_t size)
+{
+    const char *end = data + size;
+    while (data < end)
+    {
+        auto newline = static_cast<const char*>(
+            std::memchr(data, '\n', end - data));
+        if (!newline)
+        {
+            priv->partial.append(data, end);
+            return;
+        }
+
+        priv->partial.append(data, newline);
+        priv->push_physical_line(std::move(priv->partial));
+        priv->partial.clear();
+        data = newline + 1;
+    }
+}
+
+void wf::config::config_stream_parser_t::finish()
+{
+    if (!priv->partial.empty())
+    {
+        priv->push_physical_line(std::move(priv->partial));
+    }
+
+    /* A continuation on the last line joins with nothing */
+    if (priv->joiner.pending())
+    {
+        priv->apply_line(priv->joiner.get());
+    }
+
+    auto& config = priv->config;
+    auto& reloaded = priv->reloaded;
 
     // Go through all options and reset options which are loaded from the config
     // string but are not there anymore.
@@ -373,28 +524,94 @@ void wf::config::load_configuration_options_from_string(
             }
         }
     }
+
+    priv->partial.clear();
+    priv->line_idx = 1;
+    priv->joiner.reset();
+    priv->current_section.reset();
+    priv->reloaded.clear();
 }
 
-std::string wf::config::save_configuration_options_to_string(
-    const config_manager_t& config)
+void wf::config::load_configuration_options_from_string(
+    config_manager_t& config, const std::string& source,
+    const std::string& source_name)
+{
+    config_stream_parser_t parser{config, source_name};
+    parser.feed(source.data(), source.size());
+    parser.finish();
+}
+
+/**
+ * Escape the line which starts at @line_start in @buffer and spans until the
+ * end of the buffer, then terminate it with a newline.
+ */
+static void finish_line(std::string& buffer, size_t line_start)
+{
+    /* Check which characters need escaping */
+    size_t sharp = buffer.find('#', line_start);
+    while (sharp != buffer.npos)
+    {
+        buffer.insert(buffer.begin() + sharp, '\\');
+        sharp = buffer.find('#', sharp + 2);
+    }
+
+    if ((buffer.size() > line_start) && (buffer.back() == '\\'))
+    {
+        buffer += '\\';
+    }
+
+    buffer += '\n';
+}
+
+/** Size from which the buffered output is passed to the writer */
+static constexpr size_t SERIALIZE_CHUNK_SIZE = 4096;
+
+/**
+ * Serialize all sections of @config into @result. If @write is given, @result
+ * is used only as a buffer, and its contents are passed to @write whenever it
+ * grows beyond SERIALIZE_CHUNK_SIZE, as well as at the end.
+ */
+static void serialize_configuration(const wf::config::config_manager_t& config,
+    std::string& result, const wf::config::config_writer_t *write)
 {
-    std::vector<std::string> lines;
+    using namespace wf::config;
+    const auto& flush = [&] (size_t min_size)
+    {
+        if (write && !result.empty() && (result.size() >= min_size))
+        {
+            (*write)(result.data(), result.size());
+            result.clear();
+        }
+    };
+
+    /** The source of the value of a single line in a section */
+    struct option_value_t
+    {
+        /* A regular option, or nullptr */
+        const option_base_t *option = nullptr;
+        /* The value of a compound option entry, if option is nullptr */
+        const std::string *value = nullptr;
+    };
 
     for (auto& section : config.get_all_sections())
     {
-        lines.push_back("[" + section->get_name() + "]");
+        size_t line_start = result.size();
+        result += '[';
+        result += section->get_name();
+        result += ']';
+        finish_line(result, line_start);
 
         // Go through each option and add the necessary lines.
         // Take care so that regular options overwrite compound options
         // in case of conflict!
-        std::map<std::string, std::string> option_values;
+        std::map<std::string, option_value_t> option_values;
         std::set<std::string> all_compound_prefixes;
         for (auto& option : section->get_registered_options())
         {
             auto as_compound = std::dynamic_pointer_cast<compound_option_t>(option);
             if (as_compound)
             {
-                auto value = as_compound->get_value_untyped();
+                const auto& value    = as_compound->get_value_untyped();
                 const auto& prefixes = as_compound->get_entries();
                 for (auto& p : prefixes)
                 {
@@ -406,7 +623,7 @@ std::string wf::config::save_configuration_options_to_string(
                     for (size_t j = 0; j < prefixes.size(); j++)
                     {
                         auto full_name = prefixes[j]->get_prefix() + value[i][0];
-                        option_values[full_name] = value[i][j + 1];
+                        option_values[full_name] = {nullptr, &value[i][j + 1]};
                     }
                 }
             }
@@ -420,7 +637,7 @@ std::string wf::config::save_configuration_options_to_string(
                 all_compound_prefixes.begin(), all_compound_prefixes.end(),
                 [&] (const auto& prefix)
             {
-                return name.substr(0, prefix.size()) == prefix;
+                return name.compare(0, prefix.size(), prefix) == 0;
             });
         };
 
@@ -431,45 +648,89 @@ std::string wf::config::save_configuration_options_to_string(
             {
                 // Check whether this option does not conflict with a compound
                 // option entry.
-                if (xml::get_option_xml_node(option) ||
+                if (option->priv->declared_in_xml ||
                     !is_part_of_compound_option(option->get_name()))
                 {
-                    option_values[option->get_name()] = option->get_value_str();
+                    option_values[option->get_name()] = {option.get(), nullptr};
                 }
             }
         }
 
         for (auto& [name, value] : option_values)
         {
-            lines.push_back(name + " = " + value);
+            line_start = result.size();
+            result += name;
+            result += " = ";
+            if (value.option)
+            {
+                value.option->append_value_str(result);
+            } else
+            {
+                result += *value.value;
+            }
+
+            finish_line(result, line_start);
+            flush(SERIALIZE_CHUNK_SIZE);
         }
 
-        lines.push_back("");
+        result += '\n';
     }
 
-    /* Check which characters need escaping */
-    for (auto& line : lines)
+    flush(0);
+}
+
+std::string wf::config::save_configuration_options_to_string(
+    const config_manager_t& config)
+{
+    std::string result;
+    serialize_configuration(config, result, nullptr);
+    return result;
+}
+
+void wf::config::save_configuration_options(const config_manager_t& config,
+    const config_writer_t& write)
+{
+    std::string buffer;
+    buffer.reserve(SERIALIZE_CHUNK_SIZE);
+    serialize_configuration(config, buffer, &write);
+}
+
+/**
+ * Write the whole buffer to the file descriptor.
+ * @return false if an error occurred.
+ */
+static bool write_all(int fd, const char *data, size_t size)
+{
+    while (size > 0)
     {
-        size_t sharp = line.find_first_of("#");
-        while (sharp != line.npos)
+        ssize_t written = write(fd, data, size);
+        if (written < 0)
         {
-            line.insert(line.begin() + sharp, '\\');
-            sharp = line.find_first_of("#", sharp + 2);
-        }
+            if (errno == EINTR)
+            {
+                continue;
+            }
 
-        if (!line.empty() && (line.back() == '\\'))
-        {
-            line += '\\';
+            return false;
         }
+
+        data += written;
+        size -= written;
     }
 
-    std::string result;
-    for (const auto& line : lines)
+    return true;
+}
+
+bool wf::config::save_configuration_options_to_fd(const config_manager_t& config,
+    int fd)
+{
+    bool ok = true;
+    save_configuration_options(config, [&] (const char *data, size_t size)
     {
-        result += line + "\n";
-    }
+        ok = ok && write_all(fd, data, size);
+    });
 
-    return result;
+    return ok;
 }
 
 static std::string load_file_contents(const std::string& file)
@@ -502,24 +763,127 @@ bool wf::config::load_configuration_options_from_file(config_manager_t& manager,
     return true;
 }
 
-void wf::config::save_configuration_to_file(
-    const wf::config::config_manager_t& manager, const std::string& file)
+/**
+ * Stream the configuration into @file, which is truncated first. The last
+ * newline is written after the lock on @lock_fd has been released.
+ */
+static void save_configuration_in_place(
+    const wf::config::config_manager_t& manager, const std::string& file,
+    int lock_fd)
 {
-    auto contents = save_configuration_options_to_string(manager);
-    contents.pop_back(); // remove last newline
+    auto out = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (out < 0)
+    {
+        LOGE("Failed to open ", file, " for writing: ", strerror(errno));
+        flock(lock_fd, LOCK_UN);
+        return;
+    }
 
-    auto fd = open(file.c_str(), O_RDONLY);
-    flock(fd, LOCK_EX);
+    /* Hold back the last newline */
+    bool ok = true;
+    bool has_pending_newline = false;
+    wf::config::save_configuration_options(manager,
+        [&] (const char *data, size_t size)
+    {
+        if (has_pending_newline)
+        {
+            ok = ok && write_all(out, "\n", 1);
+        }
 
-    auto fout = std::ofstream(file, std::ios::trunc);
-    fout << contents;
+        has_pending_newline = (data[size - 1] == '\n');
+        ok = ok && write_all(out, data, size - has_pending_newline);
+    });
 
-    flock(fd, LOCK_UN);
-    close(fd);
+    flock(lock_fd, LOCK_UN);
 
     /* Modify the file one last time. Now programs waiting for updates can
      * acquire a shared lock. */
-    fout << std::endl;
+    ok = ok && write_all(out, "\n", 1);
+    if (!ok)
+    {
+        LOGE("Failed to write ", file, ": ", strerror(errno));
+    }
+
+    close(out);
+}
+
+/**
+ * Stream the configuration into a temporary file next to @file, and rename it
+ * over @file after the lock on @lock_fd has been released.
+ */
+static void save_configuration_by_replacing(
+    const wf::config::config_manager_t& manager, const std::string& file,
+    int lock_fd)
+{
+    /* Replace the target of a symlink, not the symlink itself */
+    std::string target = file;
+    if (char *resolved = realpath(file.c_str(), nullptr))
+    {
+        target = resolved;
+        free(resolved);
+    }
+
+    /* Other writers wait for the lock, so the name only has to be unique
+     * between processes. */
+    std::string tmp = target + ".tmp-" + std::to_string(getpid());
+    auto out = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (out < 0)
+    {
+        LOGE("Failed to open ", tmp, " for writing: ", strerror(errno));
+        flock(lock_fd, LOCK_UN);
+        return;
+    }
+
+    struct stat st;
+    if ((lock_fd >= 0) && (fstat(lock_fd, &st) == 0))
+    {
+        fchmod(out, st.st_mode & 07777);
+    }
+
+    bool ok = true;
+    wf::config::save_configuration_options(manager,
+        [&] (const char *data, size_t size)
+    {
+        ok = ok && write_all(out, data, size);
+    });
+
+    ok = ok && (fsync(out) == 0);
+    if (!ok)
+    {
+        LOGE("Failed to write ", tmp, ": ", strerror(errno));
+    }
+
+    ok = (close(out) == 0) && ok;
+
+    /* Release the lock before replacing the file. Programs waiting for
+     * updates can acquire a shared lock as soon as they see the new file. */
+    flock(lock_fd, LOCK_UN);
+    if (!ok || (rename(tmp.c_str(), target.c_str()) != 0))
+    {
+        if (ok)
+        {
+            LOGE("Failed to replace ", target, ": ", strerror(errno));
+        }
+
+        unlink(tmp.c_str());
+    }
+}
+
+void wf::config::save_configuration_to_file(
+    const wf::config::config_manager_t& manager, const std::string& file,
+    config_save_mode_t mode)
+{
+    auto fd = open(file.c_str(), O_RDONLY);
+    flock(fd, LOCK_EX);
+    if (mode == CONFIG_SAVE_REPLACE)
+    {
+        save_configuration_by_replacing(manager, file, fd);
+    } else
+    {
+        save_configuration_in_place(manager, file, fd);
+    }
+
+    close(fd);
 }
 
 /**
@@ -559,8 +923,38 @@ static xmlNodePtr find_section_start_node(const std::string& file)
     return section;
 }
 
+static bool is_on_demand(wf::config::xml_loading_mode_t mode)
+{
+    return (mode == wf::config::XML_LOAD_ON_DEMAND) ||
+           (mode == wf::config::XML_LOAD_ON_DEMAND_STREAMING);
+}
+
+static bool is_streaming(wf::config::xml_loading_mode_t mode)
+{
+    return (mode == wf::config::XML_LOAD_STREAMING) ||
+           (mode == wf::config::XML_LOAD_ON_DEMAND_STREAMING);
+}
+
+static std::shared_ptr<wf::config::section_t> load_xml_section(
+    const std::string& filename, wf::config::xml_loading_mode_t mode)
+{
+    LOGI("Reading XML configuration options from file ", filename);
+    if (is_streaming(mode))
+    {
+        return wf::config::xml::load_section_from_file(filename);
+    }
+
+    auto node = find_section_start_node(filename);
+    if (!node)
+    {
+        return nullptr;
+    }
+
+    return wf::config::xml::create_section_from_xml_node(node);
+}
+
 static wf::config::config_manager_t load_xml_files(
-    const std::vector<std::string>& xmldirs)
+    const std::vector<std::string>& xmldirs, wf::config::xml_loading_mode_t mode)
 {
     wf::config::config_manager_t manager;
 
@@ -583,16 +977,23 @@ static wf::config::config_manager_t load_xml_files(
             }
 
             std::string filename = xmldir + '/' + entry->d_name;
-            if ((filename.length() > 4) &&
-                (filename.rfind(".xml") == filename.length() - 4))
+            if ((filename.length() <= 4) ||
+                (filename.rfind(".xml") != filename.length() - 4))
+            {
+                continue;
+            }
+
+            if (is_on_demand(mode))
             {
-                LOGI("Reading XML configuration options from file ", filename);
-                auto node = find_section_start_node(filename);
-                if (node)
+                std::string name = entry->d_name;
+                name.resize(name.length() - 4);
+                manager.add_section_loader(name, [filename, mode] ()
                 {
-                    manager.merge_section(
-                        wf::config::xml::create_section_from_xml_node(node));
-                }
+                    return load_xml_section(filename, mode);
+                });
+            } else if (auto section = load_xml_section(filename, mode))
+            {
+                manager.merge_section(section);
             }
         }
 
@@ -602,46 +1003,142 @@ static wf::config::config_manager_t load_xml_files(
     return manager;
 }
 
-void override_defaults(wf::config::config_manager_t& manager,
+/**
+ * Use the values in the @sysconf file as default values for the options in
+ * @manager. The file is applied line by line, and keys which do not correspond
+ * to an existing option are reported together at the end.
+ */
+static void override_defaults(wf::config::config_manager_t& manager,
     const std::string& sysconf)
 {
-    auto sysconf_str = load_file_contents(sysconf);
+    auto lines = split_to_logical_lines(load_file_contents(sysconf));
+
+    std::string section_name;
+    std::shared_ptr<wf::config::section_t> section;
+    bool in_section = false;
+    std::string unused;
 
-    wf::config::config_manager_t overrides;
-    load_configuration_options_from_string(overrides, sysconf_str, sysconf);
-    for (auto& section : overrides.get_all_sections())
+    for (const auto& line : lines)
     {
-        for (auto& option : section->get_registered_options())
+        if (parse_section_name(line, section_name))
         {
-            auto full_name   = section->get_name() + '/' + option->get_name();
-            auto real_option = manager.get_option(full_name);
-            if (real_option)
-            {
-                if (!real_option->set_default_value_str(
-                    option->get_value_str()))
-                {
-                    LOGW("Invalid value for ", full_name, " in ", sysconf);
-                } else
-                {
-                    /* Set the value to the new default */
-                    real_option->reset_to_default();
-                }
-            } else
-            {
-                LOGW("Unused default value for ", full_name, " in ", sysconf);
-            }
+            section    = manager.get_section(section_name);
+            in_section = true;
+            continue;
+        }
+
+        if (!in_section)
+        {
+            LOGE("Error in file ", sysconf, ":", line.source_line_number,
+                ", option declared before a section starts!");
+            continue;
+        }
+
+        std::string name, value;
+        if (!split_option_line(line, name, value))
+        {
+            LOGE("Error in file ", sysconf, ":",
+                line.source_line_number, ", invalid option format ",
+                "(allowed <option_name> = <value>)");
+            continue;
+        }
+
+        auto option = section ? section->get_option_or(name) : nullptr;
+        if (!option)
+        {
+            unused += unused.empty() ? "" : ", ";
+            unused += section_name + "/" + name;
+            continue;
+        }
+
+        if (!option->set_default_value_str(value))
+        {
+            LOGW("Invalid value for ", section_name, "/", name, " in ", sysconf);
+        } else
+        {
+            /* Set the value to the new default */
+            option->reset_to_default();
         }
     }
+
+    if (!unused.empty())
+    {
+        LOGW("Unused default values in ", sysconf, ": ", unused);
+    }
 }
 
-#include <iostream>
+/** Load the sections of the plugins listed in core/plugins. */
+static void load_enabled_plugins(wf::config::config_manager_t& manager)
+{
+    if (auto plugins = manager.get_option("core/plugins"))
+    {
+        std::istringstream stream{plugins->get_value_str()};
+        std::string plugin;
+        while (stream >> plugin)
+        {
+            manager.get_section(plugin);
+        }
+    }
+}
 
 wf::config::config_manager_t wf::config::build_configuration(
     const std::vector<std::string>& xmldirs, const std::string& sysconf,
-    const std::string& userconf)
+    const std::string& userconf, xml_loading_mode_t mode)
+{
+    auto manager = load_xml_files(xmldirs, mode);
+    override_defaults(manager, sysconf);
+    load_configuration_options_from_file(manager, userconf);
+
+    if (is_on_demand(mode))
+    {
+        /* Enabled plugins will be needed right away */
+        load_enabled_plugins(manager);
+    }
+
+    return manager;
+}
+
+struct wf::config::config_schema_t::impl
 {
-    auto manager = load_xml_files(xmldirs);
+    /* Never modified after the schema is built */
+    std::vector<std::shared_ptr<const section_t>> sections;
+};
+
+wf::config::config_schema_t::config_schema_t(
+    const std::vector<std::string>& xmldirs, const std::string& sysconf)
+{
+    auto manager = load_xml_files(xmldirs, XML_LOAD_ALL);
     override_defaults(manager, sysconf);
+
+    this->priv = std::make_unique<impl>();
+    for (auto& section : manager.get_all_sections())
+    {
+        priv->sections.push_back(section);
+    }
+}
+
+wf::config::config_schema_t::~config_schema_t() = default;
+
+wf::config::config_manager_t wf::config::config_schema_t::create_configuration()
+const
+{
+    config_manager_t manager;
+    for (auto& section : priv->sections)
+    {
+        manager.add_section_loader(section->get_name(), [section] ()
+        {
+            return section->clone_with_name(section->get_name());
+        });
+    }
+
+    return manager;
+}
+
+wf::config::config_manager_t wf::config::build_configuration(
+    const config_schema_t& schema, const std::string& userconf)
+{
+    auto manager = schema.create_configuration();
     load_configuration_options_from_file(manager, userconf);
+    load_enabled_plugins(manager);
     return manager;
 }
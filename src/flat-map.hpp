@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace wf
+{
+namespace config
+{
+/**
+ * A read-only map from strings to values, stored as a vector sorted by key.
+ *
+ * It supports the lookup and iteration parts of the std::map interface, so it
+ * can be used with the helpers in name-index.hpp, but lookups are a binary
+ * search over contiguous memory instead of a walk down a tree.
+ */
+template<class Value>
+class flat_map_t
+{
+  public:
+    using value_type     = std::pair<std::string, Value>;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    flat_map_t() = default;
+
+    /** Copy the entries of the sorted map @map. */
+    template<class Map>
+    explicit flat_map_t(const Map& map) : entries(map.begin(), map.end())
+    {}
+
+    const_iterator begin() const
+    {
+        return entries.begin();
+    }
+
+    const_iterator end() const
+    {
+        return entries.end();
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    const_iterator lower_bound(const std::string& key) const
+    {
+        return std::lower_bound(entries.begin(), entries.end(), key,
+            [] (const value_type& entry, const std::string& key)
+        {
+            return entry.first < key;
+        });
+    }
+
+    const_iterator find(const std::string& key) const
+    {
+        auto it = lower_bound(key);
+        return ((it != end()) && (it->first == key)) ? it : end();
+    }
+
+    size_t count(const std::string& key) const
+    {
+        return find(key) != end();
+    }
+
+  private:
+    std::vector<value_type> entries;
+};
+}
+}
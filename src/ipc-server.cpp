@@ -0,0 +1,445 @@
+#include <wayfire/config/ipc-server.hpp>
+#include <wayfire/util/log.hpp>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <set>
+#include <system_error>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Clients which send larger frames, or which do not read their output, are
+ * disconnected. */
+static constexpr uint32_t MAX_FRAME_SIZE = 1 << 20;
+static constexpr size_t MAX_PENDING_OUTPUT = 16 << 20;
+
+struct wf::config::ipc_server_t::impl
+{
+    struct client_t
+    {
+        int fd;
+        std::string input;
+        std::string output;
+        bool waiting_writable = false;
+        bool disconnected     = false;
+
+        /* Change events caused by the client's own request, which are sent
+         * after the response */
+        bool handling_request = false;
+        std::vector<std::string> deferred_events;
+    };
+
+    struct subscription_t
+    {
+        std::shared_ptr<option_base_t> option;
+        std::string name;
+        std::set<client_t*> clients;
+        option_base_t::updated_callback_t on_updated;
+    };
+
+    config_manager_t& manager;
+    std::string socket_path;
+    int listen_fd = -1;
+    int epoll_fd  = -1;
+
+    std::map<int, std::unique_ptr<client_t>> clients;
+    std::map<option_base_t*, std::unique_ptr<subscription_t>> subscriptions;
+
+    impl(config_manager_t& manager) : manager(manager)
+    {}
+
+    void accept_clients()
+    {
+        int fd;
+        while ((fd = accept4(listen_fd, NULL, NULL,
+            SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+        {
+            epoll_event event{};
+            event.events  = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+            {
+                LOGE("Failed to watch IPC client: ", strerror(errno));
+                close(fd);
+                continue;
+            }
+
+            auto client = std::make_unique<client_t>();
+            client->fd  = fd;
+            clients[fd] = std::move(client);
+        }
+    }
+
+    /**
+     * Mark the client for removal. The client is removed at the end of the
+     * next dispatch(), which the shutdown makes sure happens soon.
+     */
+    void disconnect(client_t& client)
+    {
+        if (!client.disconnected)
+        {
+            client.disconnected = true;
+            shutdown(client.fd, SHUT_RDWR);
+        }
+    }
+
+    void read_input(client_t& client)
+    {
+        char buffer[4096];
+        bool closed = false;
+        while (true)
+        {
+            ssize_t len = read(client.fd, buffer, sizeof(buffer));
+            if (len > 0)
+            {
+                client.input.append(buffer, len);
+                continue;
+            }
+
+            if ((len < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+
+            closed = (len == 0) || (errno != EAGAIN);
+            break;
+        }
+
+        size_t offset = 0;
+        uint32_t size;
+        while (!client.disconnected &&
+               (client.input.size() - offset >= sizeof(size)))
+        {
+            std::memcpy(&size, client.input.data() + offset, sizeof(size));
+            if (size > MAX_FRAME_SIZE)
+            {
+                LOGW("IPC client sent a frame which is too large, disconnecting");
+                disconnect(client);
+                break;
+            }
+
+            if (client.input.size() - offset - sizeof(size) < size)
+            {
+                break;
+            }
+
+            offset += sizeof(size);
+            handle_request(client, client.input.substr(offset, size));
+            offset += size;
+        }
+
+        client.input.erase(0, offset);
+        if (closed)
+        {
+            disconnect(client);
+        }
+    }
+
+    void handle_request(client_t& client, const std::string& request)
+    {
+        client.handling_request = true;
+        std::string response;
+        size_t line_start = 0;
+        while (line_start < request.size())
+        {
+            size_t line_end = request.find('\n', line_start);
+            if (line_end == std::string::npos)
+            {
+                line_end = request.size();
+            }
+
+            if (line_end > line_start)
+            {
+                handle_command(client, request.substr(line_start,
+                    line_end - line_start), response);
+                response += '\n';
+            }
+
+            line_start = line_end + 1;
+        }
+
+        client.handling_request = false;
+        send_frame(client, response);
+        for (auto& event : client.deferred_events)
+        {
+            send_frame(client, event);
+        }
+
+        client.deferred_events.clear();
+    }
+
+    void handle_command(client_t& client, const std::string& line,
+        std::string& response)
+    {
+        size_t command_end = line.find(' ');
+        size_t name_end    = line.find(' ', command_end + 1);
+        std::string command = line.substr(0, command_end);
+        std::string name    = (command_end == std::string::npos) ? "" :
+            line.substr(command_end + 1, name_end - command_end - 1);
+
+        if ((command != "get") && (command != "set") &&
+            (command != "subscribe") && (command != "unsubscribe"))
+        {
+            response += "error unknown command";
+            return;
+        }
+
+        auto option = manager.get_option(name);
+        if (!option)
+        {
+            response += "error no such option";
+            return;
+        }
+
+        if (command == "get")
+        {
+            response += "ok ";
+            option->append_value_str(response);
+        } else if (command == "set")
+        {
+            std::string value = (name_end == std::string::npos) ? "" :
+                line.substr(name_end + 1);
+            response += option->set_value_str(value) ? "ok" : "error invalid value";
+        } else if (command == "subscribe")
+        {
+            subscribe(client, option, name);
+            response += "ok ";
+            option->append_value_str(response);
+        } else /* unsubscribe */
+        {
+            unsubscribe(client, option.get());
+            response += "ok";
+        }
+    }
+
+    void subscribe(client_t& client, const std::shared_ptr<option_base_t>& option,
+        const std::string& name)
+    {
+        auto& sub = subscriptions[option.get()];
+        if (!sub)
+        {
+            sub = std::make_unique<subscription_t>();
+            sub->option     = option;
+            sub->name       = name;
+            sub->on_updated = [this, sub = sub.get()] ()
+            {
+                std::string event = "changed " + sub->name + " ";
+                sub->option->append_value_str(event);
+                event += '\n';
+                for (auto& client : sub->clients)
+                {
+                    if (client->handling_request)
+                    {
+                        client->deferred_events.push_back(event);
+                    } else
+                    {
+                        send_frame(*client, event);
+                    }
+                }
+            };
+            option->add_updated_handler(&sub->on_updated);
+        }
+
+        sub->clients.insert(&client);
+    }
+
+    void unsubscribe(client_t& client, option_base_t *option)
+    {
+        auto it = subscriptions.find(option);
+        if (it == subscriptions.end())
+        {
+            return;
+        }
+
+        it->second->clients.erase(&client);
+        if (it->second->clients.empty())
+        {
+            option->rem_updated_handler(&it->second->on_updated);
+            subscriptions.erase(it);
+        }
+    }
+
+    void send_frame(client_t& client, const std::string& payload)
+    {
+        if (client.disconnected)
+        {
+            return;
+        }
+
+        uint32_t size = payload.size();
+        client.output.append((const char*)&size, sizeof(size));
+        client.output += payload;
+        flush_output(client);
+    }
+
+    void flush_output(client_t& client)
+    {
+        size_t written = 0;
+        while (written < client.output.size())
+        {
+            ssize_t len = send(client.fd, client.output.data() + written,
+                client.output.size() - written, MSG_NOSIGNAL);
+            if (len >= 0)
+            {
+                written += len;
+            } else if (errno != EINTR)
+            {
+                if (errno != EAGAIN)
+                {
+                    disconnect(client);
+                }
+
+                break;
+            }
+        }
+
+        client.output.erase(0, written);
+        if (client.output.size() > MAX_PENDING_OUTPUT)
+        {
+            LOGW("IPC client does not read its messages, disconnecting");
+            disconnect(client);
+        }
+
+        /* Wait until the rest can be written */
+        bool waiting = !client.output.empty() && !client.disconnected;
+        if (waiting != client.waiting_writable)
+        {
+            epoll_event event{};
+            event.events  = waiting ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+            event.data.fd = client.fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client.fd, &event);
+            client.waiting_writable = waiting;
+        }
+    }
+
+    void remove_client(client_t& client)
+    {
+        std::vector<option_base_t*> subscribed;
+        for (auto& [option, sub] : subscriptions)
+        {
+            if (sub->clients.count(&client))
+            {
+                subscribed.push_back(option);
+            }
+        }
+
+        for (auto& option : subscribed)
+        {
+            unsubscribe(client, option);
+        }
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client.fd, NULL);
+        close(client.fd);
+        clients.erase(client.fd);
+    }
+};
+
+wf::config::ipc_server_t::ipc_server_t(config_manager_t& manager,
+    const std::string& socket_path)
+{
+    this->priv = std::make_unique<impl>(manager);
+    priv->socket_path = socket_path;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path))
+    {
+        throw std::system_error(ENAMETOOLONG, std::generic_category(),
+            "Invalid socket path " + socket_path);
+    }
+
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    priv->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    priv->epoll_fd  = epoll_create1(EPOLL_CLOEXEC);
+    unlink(socket_path.c_str());
+
+    epoll_event event{};
+    event.events  = EPOLLIN;
+    event.data.fd = priv->listen_fd;
+    if ((priv->listen_fd < 0) || (priv->epoll_fd < 0) ||
+        bind(priv->listen_fd, (sockaddr*)&addr, sizeof(addr)) ||
+        chmod(socket_path.c_str(), S_IRUSR | S_IWUSR) ||
+        listen(priv->listen_fd, SOMAXCONN) ||
+        epoll_ctl(priv->epoll_fd, EPOLL_CTL_ADD, priv->listen_fd, &event))
+    {
+        int error = errno;
+        close(priv->listen_fd);
+        close(priv->epoll_fd);
+        throw std::system_error(error, std::generic_category(),
+            "Failed to listen on " + socket_path);
+    }
+}
+
+wf::config::ipc_server_t::~ipc_server_t()
+{
+    while (!priv->clients.empty())
+    {
+        priv->remove_client(*priv->clients.begin()->second);
+    }
+
+    close(priv->listen_fd);
+    close(priv->epoll_fd);
+    unlink(priv->socket_path.c_str());
+}
+
+int wf::config::ipc_server_t::get_fd() const
+{
+    return priv->epoll_fd;
+}
+
+void wf::config::ipc_server_t::dispatch()
+{
+    epoll_event events[32];
+    int count;
+    while ((count = epoll_wait(priv->epoll_fd, events, 32, 0)) > 0)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == priv->listen_fd)
+            {
+                priv->accept_clients();
+                continue;
+            }
+
+            auto it = priv->clients.find(fd);
+            if (it == priv->clients.end())
+            {
+                continue;
+            }
+
+            auto& client = *it->second;
+            if (events[i].events & EPOLLOUT)
+            {
+                priv->flush_output(client);
+            }
+
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                priv->read_input(client);
+            }
+        }
+
+        /* Clients may also be disconnected when sending change events, so
+         * they are removed only here. */
+        std::vector<impl::client_t*> disconnected;
+        for (auto& [_, client] : priv->clients)
+        {
+            if (client->disconnected)
+            {
+                disconnected.push_back(client.get());
+            }
+        }
+
+        for (auto& client : disconnected)
+        {
+            priv->remove_client(*client);
+        }
+    }
+}
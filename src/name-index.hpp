@@ -0,0 +1,45 @@
+#pragma once
+
+#include <fnmatch.h>
+#include <string>
+
+namespace wf
+{
+namespace config
+{
+/**
+ * Call @callback for each entry of the sorted map @map whose key begins with
+ * @prefix. Only the matching range of the map is visited.
+ */
+template<class Map, class Callback>
+void for_each_with_prefix(Map& map, const std::string& prefix,
+    Callback&& callback)
+{
+    for (auto it = map.lower_bound(prefix);
+         (it != map.end()) && (it->first.compare(0, prefix.size(), prefix) == 0);
+         ++it)
+    {
+        callback(*it);
+    }
+}
+
+/**
+ * Call @callback for each entry of the sorted map @map whose key matches the
+ * shell-style pattern @pattern (see fnmatch(3)). Only the keys which begin
+ * with the part of the pattern before the first special character are tested.
+ */
+template<class Map, class Callback>
+void for_each_matching(Map& map, const std::string& pattern,
+    Callback&& callback)
+{
+    auto prefix = pattern.substr(0, pattern.find_first_of("*?[\\"));
+    for_each_with_prefix(map, prefix, [&] (auto& entry)
+    {
+        if (fnmatch(pattern.c_str(), entry.first.c_str(), 0) == 0)
+        {
+            callback(entry);
+        }
+    });
+}
+}
+}
@@ -0,0 +1,158 @@
+#include "notification-queue.hpp"
+#include "option-impl.hpp"
+#include <wayfire/util/log.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+wf::config::notification_queue_t::notification_queue_t() :
+    owner(std::this_thread::get_id())
+{
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(),
+            "Failed to create eventfd");
+    }
+}
+
+wf::config::notification_queue_t::~notification_queue_t()
+{
+    for (auto& weak : watched)
+    {
+        if (auto option = weak.lock())
+        {
+            unwatch(*option);
+        }
+    }
+
+    node_t *node = head.exchange(nullptr, std::memory_order_acquire);
+    while (node)
+    {
+        auto next = node->next;
+        delete node;
+        node = next;
+    }
+
+    close(fd);
+}
+
+void wf::config::notification_queue_t::watch_section(
+    const std::shared_ptr<section_t>& section)
+{
+    for (auto& option : section->get_registered_options())
+    {
+        if (option->priv->notification_queue != this)
+        {
+            option->priv->notification_queue = this;
+            option->priv->self = option;
+            watched.push_back(option);
+        }
+    }
+}
+
+void wf::config::notification_queue_t::forget_section(
+    const std::shared_ptr<section_t>& section)
+{
+    for (auto& option : section->get_registered_options())
+    {
+        if (option->priv->notification_queue == this)
+        {
+            unwatch(*option);
+        }
+    }
+
+    watched.erase(std::remove_if(watched.begin(), watched.end(),
+        [&] (auto& weak)
+    {
+        auto option = weak.lock();
+        return !option || (option->priv->notification_queue != this);
+    }), watched.end());
+}
+
+void wf::config::notification_queue_t::unwatch(option_base_t& option)
+{
+    option.priv->notification_queue = nullptr;
+    option.priv->self.reset();
+    option.priv->notification_pending = false;
+}
+
+bool wf::config::notification_queue_t::push(const option_base_t& option)
+{
+    if (std::this_thread::get_id() == owner)
+    {
+        return false;
+    }
+
+    /* Already queued and not dispatched yet */
+    if (option.priv->notification_pending.exchange(true))
+    {
+        return true;
+    }
+
+    /* The node may be dispatched as soon as it is pushed, so it must not be
+     * accessed after that. */
+    node_t *next = head.load(std::memory_order_relaxed);
+    auto node    = new node_t{option.priv->self, next};
+    while (!head.compare_exchange_weak(next, node,
+        std::memory_order_release, std::memory_order_relaxed))
+    {
+        node->next = next;
+    }
+
+    /* Only the first notification after a dispatch needs to wake up the
+     * owner, the others are picked up by the same dispatch. */
+    if (!next)
+    {
+        uint64_t one = 1;
+        if (write(fd, &one, sizeof(one)) < 0)
+        {
+            LOGE("Failed to signal pending option notifications: ",
+                strerror(errno));
+        }
+    }
+
+    return true;
+}
+
+void wf::config::notification_queue_t::dispatch()
+{
+    /* Reset the eventfd before taking the list, so that notifications pushed
+     * after that signal it again. Fails with EAGAIN if it was not signalled. */
+    uint64_t count;
+    ssize_t unused = read(fd, &count, sizeof(count));
+    (void)unused;
+
+    /* The list is in reverse order of pushing, restore the order of changes */
+    node_t *node = head.exchange(nullptr, std::memory_order_acquire);
+    node_t *ordered = nullptr;
+    while (node)
+    {
+        auto next = node->next;
+        node->next = ordered;
+        ordered    = node;
+        node = next;
+    }
+
+    while (ordered)
+    {
+        auto option = ordered->option.lock();
+        auto next   = ordered->next;
+        delete ordered;
+        ordered = next;
+
+        if (option && option->priv->notification_pending.exchange(false))
+        {
+            option_base_t::impl::run_updated_handlers(*option);
+        }
+    }
+}
+
+int wf::config::notification_queue_t::get_fd() const
+{
+    return fd;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <wayfire/config/config-manager.hpp>
+#include <atomic>
+#include <thread>
+
+namespace wf
+{
+namespace config
+{
+/**
+ * Defers the updated handlers of options which are changed from threads other
+ * than the one which created the queue (the owner).
+ *
+ * Changes are pushed onto a lock-free list and announced via an eventfd. The
+ * owner runs the handlers from dispatch(), which should be called whenever the
+ * eventfd becomes readable. Multiple changes of the same option before the
+ * next dispatch() result in a single notification.
+ */
+class notification_queue_t
+{
+  public:
+    /** @throws std::system_error if the eventfd could not be created. */
+    notification_queue_t();
+
+    /** Stop deferring the notifications of all watched options. */
+    ~notification_queue_t();
+
+    /** Start deferring the notifications of the options in @section. */
+    void watch_section(const std::shared_ptr<section_t>& section);
+
+    /** Stop deferring the notifications of the options in @section. */
+    void forget_section(const std::shared_ptr<section_t>& section);
+
+    /**
+     * Queue a notification for @option.
+     *
+     * @return false if called from the owner thread, in which case nothing is
+     *   queued and the handlers should run right away.
+     */
+    bool push(const option_base_t& option);
+
+    /** Run the handlers of all options changed since the last dispatch. */
+    void dispatch();
+
+    int get_fd() const;
+
+  private:
+    struct node_t
+    {
+        std::weak_ptr<option_base_t> option;
+        node_t *next;
+    };
+
+    /* Pushed by any thread, taken as a whole by the owner */
+    std::atomic<node_t*> head{nullptr};
+
+    /* Accessed only from the owner thread */
+    std::vector<std::weak_ptr<option_base_t>> watched;
+
+    const std::thread::id owner;
+    int fd;
+
+    void unwatch(option_base_t& option);
+};
+}
+}
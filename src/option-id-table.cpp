@@ -0,0 +1,62 @@
+#include "option-id-table.hpp"
+#include "option-impl.hpp"
+
+wf::config::option_id_table_t::~option_id_table_t()
+{
+    for (auto& option : options)
+    {
+        if (option)
+        {
+            option->priv->id_table = nullptr;
+            option->priv->id_section = nullptr;
+        }
+    }
+}
+
+void wf::config::option_id_table_t::assign(const section_t& section)
+{
+    for (auto& option : section.get_registered_options())
+    {
+        if (option->priv->id_table != this)
+        {
+            /* An option which is moved from another manager keeps only the
+             * ID in this one */
+            if (option->priv->id_table)
+            {
+                option->priv->id_table->remove(*option);
+            }
+
+            option->priv->id_table = this;
+            option->priv->id_section = &section;
+            option->priv->id = options.size();
+            options.push_back(option);
+        }
+    }
+}
+
+void wf::config::option_id_table_t::remove(option_base_t& option)
+{
+    if (option.priv->id_table == this)
+    {
+        /* The slot may hold the last reference to @option */
+        auto released = std::move(options[option.priv->id]);
+        option.priv->id_table = nullptr;
+        option.priv->id_section = nullptr;
+    }
+}
+
+wf::config::option_id_table_t::option_id_t wf::config::option_id_table_t::find(
+    const option_base_t& option) const
+{
+    return (option.priv->id_table == this) ? option.priv->id :
+           config_manager_t::INVALID_OPTION_ID;
+}
+
+void wf::config::forget_option_id(option_base_t& option,
+    const section_t& section)
+{
+    if (option.priv->id_table && (option.priv->id_section == &section))
+    {
+        option.priv->id_table->remove(option);
+    }
+}
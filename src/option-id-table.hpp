@@ -0,0 +1,59 @@
+#pragma once
+
+#include <wayfire/config/config-manager.hpp>
+
+namespace wf
+{
+namespace config
+{
+/**
+ * The options of a config manager by ID, see
+ * config_manager_t::assign_option_ids().
+ *
+ * Each option remembers its ID and the section it was registered in when it
+ * got the ID, so that unregistering it from that section (or replacing it with
+ * another option of the same name) clears its slot.
+ */
+class option_id_table_t
+{
+  public:
+    using option_id_t = config_manager_t::option_id_t;
+
+    /** Release all options, so that they can be given IDs by another table. */
+    ~option_id_table_t();
+
+    /** Assign an ID to each option of @section which does not have one yet. */
+    void assign(const section_t& section);
+
+    /** Clear the slot of @option, if it has an ID in this table. */
+    void remove(option_base_t& option);
+
+    /**
+     * @return The ID of @option, or INVALID_OPTION_ID if it has no ID in this
+     *   table.
+     */
+    option_id_t find(const option_base_t& option) const;
+
+    /** @return The option with the given ID, or nullptr. */
+    option_base_t *get(option_id_t id) const
+    {
+        return (id < options.size()) ? options[id].get() : nullptr;
+    }
+
+    size_t size() const
+    {
+        return options.size();
+    }
+
+  private:
+    /* nullptr for removed options */
+    std::vector<std::shared_ptr<option_base_t>> options;
+};
+
+/**
+ * Clear the slot of @option in the ID table of its config manager, if it got
+ * its ID as part of @section. Called when @option leaves @section.
+ */
+void forget_option_id(option_base_t& option, const section_t& section);
+}
+}
@@ -3,21 +3,50 @@
 #include <wayfire/config/compound-option.hpp>
 #include <wayfire/config/section.hpp>
 #include <libxml/tree.h>
+#include <atomic>
 #include <stdint.h>
 
+namespace wf
+{
+namespace config
+{
+class notification_queue_t;
+class option_id_table_t;
+}
+}
+
 struct wf::config::option_base_t::impl
 {
     std::string name;
-    std::vector<updated_callback_t*> updated_handlers;
-
-    // Number of times the option has been locked
-    int32_t lock_count = 0;
 
     // Associated XML node
-    xmlNode *xml;
+    xmlNode *xml = nullptr;
+
+    // Is option declared in an XML file? Also set for options which were
+    // streamed from the file and have no XML node.
+    bool declared_in_xml = false;
 
     // Is option in config file?
     bool option_in_config_file = false;
+
+    // Queue for notifications from other threads, see notification_queue_t
+    notification_queue_t *notification_queue = nullptr;
+    // The option itself, set while it is in a notification queue
+    std::weak_ptr<option_base_t> self;
+    // Whether a notification is queued and not dispatched yet
+    std::atomic<bool> notification_pending{false};
+
+    // The ID table of the config manager which gave the option an ID, the
+    // section the option was in at that time, and the ID itself
+    option_id_table_t *id_table = nullptr;
+    const section_t *id_section = nullptr;
+    uint32_t id = 0;
+
+    // Statistics of the updated handlers, collected while profiling
+    std::vector<handler_profile_t> profile;
+
+    /** Run the updated handlers of @option on the calling thread. */
+    static void run_updated_handlers(const option_base_t& option);
 };
 
 namespace wf
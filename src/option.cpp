@@ -2,26 +2,40 @@
 #include <algorithm>
 #include <vector>
 
+#include "notification-queue.hpp"
 #include "option-impl.hpp"
 #include "wayfire/util/log.hpp"
 
+/* Whether the duration of updated handlers is measured */
+static std::atomic<bool> profiling_enabled{false};
+
 std::string wf::config::option_base_t::get_name() const
 {
     return this->priv->name;
 }
 
+void wf::config::option_base_t::append_value_str(std::string& out) const
+{
+    out += get_value_str();
+}
+
+bool wf::config::option_base_t::assign_from(const option_base_t&)
+{
+    return false;
+}
+
 void wf::config::option_base_t::add_updated_handler(
     updated_callback_t *callback)
 {
-    this->priv->updated_handlers.push_back(callback);
+    this->updated_handlers.push_back(callback);
 }
 
 void wf::config::option_base_t::rem_updated_handler(
     updated_callback_t *callback)
 {
-    auto it = std::remove(priv->updated_handlers.begin(),
-        priv->updated_handlers.end(), callback);
-    priv->updated_handlers.erase(it, priv->updated_handlers.end());
+    auto it = std::remove(updated_handlers.begin(),
+        updated_handlers.end(), callback);
+    updated_handlers.erase(it, updated_handlers.end());
 }
 
 wf::config::option_base_t::option_base_t(const std::string& name)
@@ -34,17 +48,76 @@ wf::config::option_base_t::~option_base_t() = default;
 
 void wf::config::option_base_t::notify_updated() const
 {
-    auto to_call = priv->updated_handlers;
+    if (priv->notification_queue && priv->notification_queue->push(*this))
+    {
+        return;
+    }
+
+    impl::run_updated_handlers(*this);
+}
+
+void wf::config::option_base_t::impl::run_updated_handlers(
+    const option_base_t& option)
+{
+    auto to_call = option.updated_handlers;
+    if (!profiling_enabled.load(std::memory_order_relaxed))
+    {
+        for (auto& call : to_call)
+        {
+            (*call)();
+        }
+
+        return;
+    }
+
     for (auto& call : to_call)
     {
+        auto start = std::chrono::steady_clock::now();
         (*call)();
+        auto duration = std::chrono::steady_clock::now() - start;
+
+        auto& profile = option.priv->profile;
+        auto it = std::find_if(profile.begin(), profile.end(),
+            [&] (const handler_profile_t& entry)
+        {
+            return entry.handler == call;
+        });
+        if (it == profile.end())
+        {
+            it = profile.insert(profile.end(), handler_profile_t{call});
+        }
+
+        it->calls++;
+        it->total += duration;
+        it->max    = std::max<std::chrono::nanoseconds>(it->max, duration);
     }
 }
 
+void wf::config::option_base_t::set_profiling(bool enabled)
+{
+    profiling_enabled = enabled;
+}
+
+bool wf::config::option_base_t::is_profiling()
+{
+    return profiling_enabled;
+}
+
+std::vector<wf::config::option_base_t::handler_profile_t> wf::config::
+option_base_t::get_handler_profile() const
+{
+    return this->priv->profile;
+}
+
+void wf::config::option_base_t::reset_handler_profile()
+{
+    this->priv->profile.clear();
+}
+
 void wf::config::option_base_t::set_locked(bool locked)
 {
-    this->priv->lock_count += (locked ? 1 : -1);
-    if (priv->lock_count < 0)
+    this->lock_count += (locked ? 1 : -1);
+    if (lock_count < 0)
     {
         LOGE("Lock counter for option ", this->get_name(), " dropped below zero!");
     }
@@ -52,11 +125,12 @@ void wf::config::option_base_t::set_locked(bool locked)
 
 bool wf::config::option_base_t::is_locked() const
 {
-    return this->priv->lock_count > 0;
+    return this->lock_count > 0;
 }
 
 void wf::config::option_base_t::init_clone(option_base_t& other) const
 {
     other.priv->xml  = this->priv->xml;
     other.priv->name = this->priv->name;
+    other.priv->declared_in_xml = this->priv->declared_in_xml;
 }
@@ -4,6 +4,8 @@
 #include <libxml/tree.h>
 #include <map>
 
+#include "flat-map.hpp"
+
 struct wf::config::section_t::impl
 {
   public:
@@ -12,4 +14,26 @@ struct wf::config::section_t::impl
 
     // Associated XML node
     xmlNode *xml = NULL;
+
+    // Replaces @options while the section is frozen
+    flat_map_t<std::shared_ptr<option_base_t>> frozen_options;
+    bool frozen = false;
+
+    /** Call @callback with the container which currently holds the options. */
+    template<class Callback>
+    auto with_options(Callback&& callback) const
+    {
+        return frozen ? callback(frozen_options) : callback(options);
+    }
+
+    /** Move the options back to @options, so that they can be modified. */
+    void thaw()
+    {
+        if (frozen)
+        {
+            options  = {frozen_options.begin(), frozen_options.end()};
+            frozen_options = {};
+            frozen = false;
+        }
+    }
 };
@@ -1,5 +1,7 @@
 #include <stdexcept>
 #include "section-impl.hpp"
+#include "name-index.hpp"
+#include "option-id-table.hpp"
 
 wf::config::section_t::section_t(const std::string& name)
 {
@@ -18,9 +20,9 @@ std::shared_ptr<wf::config::section_t> wf::config::section_t::clone_with_name(
     const std::string name) const
 {
     auto result = std::make_shared<wf::config::section_t>(name);
-    for (auto& option : priv->options)
+    for (auto& option : get_registered_options())
     {
-        result->register_new_option(option.second->clone_option());
+        result->register_new_option(option->clone_option());
     }
 
     result->priv->xml = this->priv->xml;
@@ -30,12 +32,11 @@ std::shared_ptr<wf::config::section_t> wf::config::section_t::clone_with_name(
 std::shared_ptr<wf::config::option_base_t> wf::config::section_t::get_option_or(
     const std::string& name)
 {
-    if (this->priv->options.count(name))
+    return priv->with_options([&] (auto& options)
     {
-        return this->priv->options[name];
-    }
-
-    return nullptr;
+        auto it = options.find(name);
+        return (it == options.end()) ? nullptr : it->second;
+    });
 }
 
 std::shared_ptr<wf::config::option_base_t> wf::config::section_t::get_option(
@@ -55,10 +56,44 @@ wf::config::section_t::option_list_t wf::config::section_t::get_registered_optio
 const
 {
     option_list_t list;
-    for (auto& option : priv->options)
+    priv->with_options([&] (auto& options)
     {
-        list.push_back(option.second);
-    }
+        list.reserve(options.size());
+        for (auto& option : options)
+        {
+            list.push_back(option.second);
+        }
+    });
+
+    return list;
+}
+
+wf::config::section_t::option_list_t wf::config::section_t::
+get_options_with_prefix(const std::string& prefix) const
+{
+    option_list_t list;
+    priv->with_options([&] (auto& options)
+    {
+        for_each_with_prefix(options, prefix, [&] (auto& option)
+        {
+            list.push_back(option.second);
+        });
+    });
+
+    return list;
+}
+
+wf::config::section_t::option_list_t wf::config::section_t::find_options(
+    const std::string& pattern) const
+{
+    option_list_t list;
+    priv->with_options([&] (auto& options)
+    {
+        for_each_matching(options, pattern, [&] (auto& option)
+        {
+            list.push_back(option.second);
+        });
+    });
 
     return list;
 }
@@ -72,7 +107,14 @@ void wf::config::section_t::register_new_option(
             "Cannot add null option to section " + this->get_name());
     }
 
-    this->priv->options[option->get_name()] = option;
+    this->priv->thaw();
+    auto& slot = this->priv->options[option->get_name()];
+    if (slot && (slot != option))
+    {
+        forget_option_id(*slot, *this);
+    }
+
+    slot = option;
 }
 
 void wf::config::section_t::unregister_option(
@@ -83,9 +125,26 @@ void wf::config::section_t::unregister_option(
         return;
     }
 
+    this->priv->thaw();
     auto it = this->priv->options.find(option->get_name());
     if ((it != this->priv->options.end()) && (it->second == option))
     {
         this->priv->options.erase(it);
+        forget_option_id(*option, *this);
+    }
+}
+
+void wf::config::section_t::freeze()
+{
+    if (!priv->frozen)
+    {
+        priv->frozen_options = decltype(priv->frozen_options){priv->options};
+        priv->options.clear();
+        priv->frozen = true;
     }
 }
+
+bool wf::config::section_t::is_frozen() const
+{
+    return priv->frozen;
+}
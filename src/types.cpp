@@ -6,6 +6,14 @@
 
 #include <libevdev/libevdev.h>
 #include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <type_traits>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
 
 /* --------------------------- Primitive types ------------------------------ */
 template<>
@@ -70,6 +78,50 @@ stdx::optional<std::string> wf::option_type::from_string(const std::string& valu
     return value;
 }
 
+/** Implement to_string() for types which specialize append_to(). */
+template<class Type>
+static std::string to_string_via_append(const Type& value)
+{
+    std::string result;
+    wf::option_type::append_to<Type>(result, value);
+    return result;
+}
+
+template<>
+void wf::option_type::append_to(std::string& out, const bool& value)
+{
+    out += value ? "true" : "false";
+}
+
+template<>
+void wf::option_type::append_to(std::string& out, const int& value)
+{
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+template<>
+void wf::option_type::append_to(std::string& out, const double& value)
+{
+    /* Same format as std::to_string(double) */
+    char buffer[64];
+    int length = std::snprintf(buffer, sizeof(buffer), "%f", value);
+    if ((length >= 0) && (length < (int)sizeof(buffer)))
+    {
+        out.append(buffer, length);
+    } else
+    {
+        out += std::to_string(value);
+    }
+}
+
+template<>
+void wf::option_type::append_to(std::string& out, const std::string& value)
+{
+    out += value;
+}
+
 template<>
 std::string wf::option_type::to_string(
     const bool& value)
@@ -115,18 +167,12 @@ wf::color_t::color_t(const glm::vec4& value) :
     color_t(value.r, value.g, value.b, value.a)
 {}
 
-static double hex_to_double(std::string value)
-{
-    char *dummy;
-    return std::strtol(value.c_str(), &dummy, 16);
-}
-
 static stdx::optional<wf::color_t> try_parse_rgba(const std::string& value)
 {
     wf::color_t parsed = {0, 0, 0, 0};
-    std::stringstream ss(value);
+    std::istringstream ss(value);
+    ss.imbue(std::locale::classic());
 
-    auto old = std::locale::global(std::locale::classic());
     bool valid_color =
         (bool)(ss >> parsed.r >> parsed.g >> parsed.b >> parsed.a);
 
@@ -134,87 +180,169 @@ static stdx::optional<wf::color_t> try_parse_rgba(const std::string& value)
     std::string dummy;
     valid_color &= !(bool)(ss >> dummy);
 
-    std::locale::global(old);
-
     return valid_color ? parsed : stdx::optional<wf::color_t>{};
 }
 
-#include <iostream>
-static const std::string hex_digits = "0123456789ABCDEF";
-template<>
-stdx::optional<wf::color_t> wf::option_type::from_string(
-    const std::string& param_value)
+/** Marks characters which are not hex digits in hex_digit_values. */
+static constexpr uint8_t invalid_hex_digit = 0xFF;
+
+/** Maps each character to its value as a hex digit. */
+static const struct hex_digit_table_t
 {
-    auto value = param_value;
-    for (auto& ch : value)
-    {
-        ch = std::toupper(ch);
-    }
+    uint8_t values[256];
 
-    auto as_rgba = try_parse_rgba(value);
-    if (as_rgba)
+    hex_digit_table_t() : values{}
     {
-        return as_rgba;
+        for (auto& v : values)
+        {
+            v = invalid_hex_digit;
+        }
+
+        for (int i = 0; i < 10; i++)
+        {
+            values['0' + i] = i;
+        }
+
+        for (int i = 0; i < 6; i++)
+        {
+            values['a' + i] = 10 + i;
+            values['A' + i] = 10 + i;
+        }
     }
+} hex_digit_values;
 
-    /* Either #RGBA or #RRGGBBAA */
-    if ((value.size() != 5) && (value.size() != 9))
+#ifdef __SSE2__
+/**
+ * Decode the 8 hex digits of a #RRGGBBAA color with SSE2.
+ * Reads exactly 8 bytes from @hex.
+ */
+static bool decode_rrggbbaa(const char *hex, uint8_t bytes[4])
+{
+    const __m128i chars = _mm_loadl_epi64((const __m128i*)hex);
+    const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+
+    /* Bytes >= 0x80 are negative, so they fail both range checks. */
+    const __m128i is_digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    const __m128i is_alpha = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+    const __m128i valid = _mm_or_si128(is_digit, is_alpha);
+    if ((_mm_movemask_epi8(valid) & 0xFF) != 0xFF)
     {
-        return {};
+        return false;
     }
 
-    if (value[0] != '#')
+    const __m128i digit_values = _mm_and_si128(is_digit,
+        _mm_sub_epi8(chars, _mm_set1_epi8('0')));
+    const __m128i alpha_values = _mm_and_si128(is_alpha,
+        _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)));
+    const __m128i nibbles = _mm_or_si128(digit_values, alpha_values);
+
+    /* Each 16-bit lane holds the high nibble in its low byte and the low
+     * nibble in its high byte. */
+    const __m128i high = _mm_slli_epi16(
+        _mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4);
+    const __m128i low = _mm_srli_epi16(nibbles, 8);
+    const __m128i packed = _mm_packus_epi16(_mm_or_si128(high, low), high);
+
+    uint32_t result = _mm_cvtsi128_si32(packed);
+    std::memcpy(bytes, &result, 4);
+    return true;
+}
+
+#else
+static bool decode_rrggbbaa(const char *hex, uint8_t bytes[4])
+{
+    uint8_t invalid = 0;
+    for (int i = 0; i < 4; i++)
     {
-        return {};
+        uint8_t hi = hex_digit_values.values[(uint8_t)hex[2 * i]];
+        uint8_t lo = hex_digit_values.values[(uint8_t)hex[2 * i + 1]];
+        invalid |= (hi | lo) & 0xF0;
+        bytes[i]  = (hi << 4) | (lo & 0x0F);
     }
 
-    if (value.find_first_not_of(hex_digits, 1) != std::string::npos)
+    return invalid == 0;
+}
+
+#endif
+
+template<>
+stdx::optional<wf::color_t> wf::option_type::from_string(
+    const std::string& value)
+{
+    if (value.empty() || (value[0] != '#'))
     {
-        return {};
+        return try_parse_rgba(value);
     }
 
-    double r, g, b, a;
+    uint8_t channels[4];
 
-    /* #RRGGBBAA case */
+    /* Either #RGBA or #RRGGBBAA */
     if (value.size() == 9)
     {
-        r = hex_to_double(value.substr(1, 2)) / 255.0;
-        g = hex_to_double(value.substr(3, 2)) / 255.0;
-        b = hex_to_double(value.substr(5, 2)) / 255.0;
-        a = hex_to_double(value.substr(7, 2)) / 255.0;
-    } else
+        if (!decode_rrggbbaa(value.data() + 1, channels))
+        {
+            return {};
+        }
+
+        return wf::color_t{channels[0] / 255.0, channels[1] / 255.0,
+            channels[2] / 255.0, channels[3] / 255.0};
+    }
+
+    if (value.size() == 5)
     {
-        assert(value.size() == 5);
-        r = hex_to_double(value.substr(1, 1)) / 15.0;
-        g = hex_to_double(value.substr(2, 1)) / 15.0;
-        b = hex_to_double(value.substr(3, 1)) / 15.0;
-        a = hex_to_double(value.substr(4, 1)) / 15.0;
+        uint8_t invalid = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            channels[i] = hex_digit_values.values[(uint8_t)value[i + 1]];
+            invalid    |= channels[i] & 0xF0;
+        }
+
+        if (invalid)
+        {
+            return {};
+        }
+
+        return wf::color_t{channels[0] / 15.0, channels[1] / 15.0,
+            channels[2] / 15.0, channels[3] / 15.0};
     }
 
-    return wf::color_t{r, g, b, a};
+    return {};
 }
 
+static const char hex_digits[] = "0123456789ABCDEF";
 template<>
-std::string wf::option_type::to_string(const color_t& value)
+void wf::option_type::append_to(std::string& out, const color_t& value)
 {
     const int max_byte = 255;
     const int min_byte = 0;
 
-    auto to_hex = [=] (double number_d)
+    char buffer[9];
+    buffer[0] = '#';
+
+    const double channels[4] = {value.r, value.g, value.b, value.a};
+    for (int i = 0; i < 4; i++)
     {
-        int number = std::round(number_d);
+        int number = std::round(channels[i] * max_byte);
         /* Clamp */
         number = std::min(number, max_byte);
         number = std::max(number, min_byte);
 
-        std::string result;
-        result += hex_digits[number / 16];
-        result += hex_digits[number % 16];
-        return result;
-    };
+        buffer[2 * i + 1] = hex_digits[number >> 4];
+        buffer[2 * i + 2] = hex_digits[number & 0xF];
+    }
 
-    return "#" + to_hex(value.r * max_byte) + to_hex(value.g * max_byte) +
-           to_hex(value.b * max_byte) + to_hex(value.a * max_byte);
+    out.append(buffer, sizeof(buffer));
+}
+
+template<>
+std::string wf::option_type::to_string(const color_t& value)
+{
+    return to_string_via_append(value);
 }
 
 bool wf::color_t::operator ==(const color_t& other) const
@@ -282,23 +410,29 @@ static std::map<std::string, wf::keyboard_modifier_t> modifier_names =
     {"super", wf::KEYBOARD_MODIFIER_LOGO},
 };
 
-static std::string binding_to_string(general_binding_t binding)
+static void append_binding(std::string& out, general_binding_t binding)
 {
-    std::string result = "";
     for (auto& pair : modifier_names)
     {
         if (binding.mods & pair.second)
         {
-            result += "<" + pair.first + "> ";
+            out += '<';
+            out += pair.first;
+            out += "> ";
         }
     }
 
     if (binding.value > 0)
     {
         auto evdev_name = libevdev_event_code_get_name(EV_KEY, binding.value);
-        result += evdev_name ?: "NULL";
+        out += evdev_name ?: "NULL";
     }
+}
 
+static std::string binding_to_string(general_binding_t binding)
+{
+    std::string result;
+    append_binding(result, binding);
     return result;
 }
 
@@ -408,18 +542,15 @@ wf::keybinding_t::keybinding_t(uint32_t modifier, uint32_t keyval)
     this->keyval = keyval;
 }
 
-template<>
-stdx::optional<wf::keybinding_t> wf::option_type::from_string(
-    const std::string& description)
+/**
+ * Interpret an already parsed binding as a keybinding.
+ *
+ * @param description The original description, used to tell keys and buttons
+ *   apart, since evdev treats them the same.
+ */
+static stdx::optional<wf::keybinding_t> binding_as_key(
+    const general_binding_t& parsed, const std::string& description)
 {
-    auto parsed_opt = parse_binding(description);
-    if (!parsed_opt)
-    {
-        return {};
-    }
-
-    auto parsed = parsed_opt.value();
-
     /* Disallow buttons, because evdev treats buttons and keys the same */
     if (parsed.enabled && (parsed.value > 0) &&
         (description.find("KEY") == std::string::npos))
@@ -436,14 +567,34 @@ stdx::optional<wf::keybinding_t> wf::option_type::from_string(
 }
 
 template<>
-std::string wf::option_type::to_string(const wf::keybinding_t& value)
+stdx::optional<wf::keybinding_t> wf::option_type::from_string(
+    const std::string& description)
+{
+    auto parsed_opt = parse_binding(description);
+    if (!parsed_opt)
+    {
+        return {};
+    }
+
+    return binding_as_key(parsed_opt.value(), description);
+}
+
+template<>
+void wf::option_type::append_to(std::string& out, const wf::keybinding_t& value)
 {
     if ((value.get_modifiers() == 0) && (value.get_key() == 0))
     {
-        return "none";
+        out += "none";
+        return;
     }
 
-    return binding_to_string({true, value.get_modifiers(), value.get_key()});
+    append_binding(out, {true, value.get_modifiers(), value.get_key()});
+}
+
+template<>
+std::string wf::option_type::to_string(const wf::keybinding_t& value)
+{
+    return to_string_via_append(value);
 }
 
 bool wf::keybinding_t::operator ==(const keybinding_t& other) const
@@ -470,17 +621,13 @@ wf::buttonbinding_t::buttonbinding_t(uint32_t modifier, uint32_t buttonval)
     this->button = buttonval;
 }
 
-template<>
-stdx::optional<wf::buttonbinding_t> wf::option_type::from_string(
-    const std::string& description)
+/**
+ * Interpret an already parsed binding as a buttonbinding.
+ * See binding_as_key() for the meaning of @description.
+ */
+static stdx::optional<wf::buttonbinding_t> binding_as_button(
+    const general_binding_t& parsed, const std::string& description)
 {
-    auto parsed_opt = parse_binding(description);
-    if (!parsed_opt)
-    {
-        return {};
-    }
-
-    auto parsed = parsed_opt.value();
     if (!parsed.enabled)
     {
         return wf::buttonbinding_t{0, 0};
@@ -501,15 +648,36 @@ stdx::optional<wf::buttonbinding_t> wf::option_type::from_string(
 }
 
 template<>
-std::string wf::option_type::to_string(
+stdx::optional<wf::buttonbinding_t> wf::option_type::from_string(
+    const std::string& description)
+{
+    auto parsed_opt = parse_binding(description);
+    if (!parsed_opt)
+    {
+        return {};
+    }
+
+    return binding_as_button(parsed_opt.value(), description);
+}
+
+template<>
+void wf::option_type::append_to(std::string& out,
     const wf::buttonbinding_t& value)
 {
     if ((value.get_modifiers() == 0) && (value.get_button() == 0))
     {
-        return "none";
+        out += "none";
+        return;
     }
 
-    return binding_to_string({true, value.get_modifiers(), value.get_button()});
+    append_binding(out, {true, value.get_modifiers(), value.get_button()});
+}
+
+template<>
+std::string wf::option_type::to_string(
+    const wf::buttonbinding_t& value)
+{
+    return to_string_via_append(value);
 }
 
 bool wf::buttonbinding_t::operator ==(const buttonbinding_t& other) const
@@ -535,127 +703,144 @@ wf::touchgesture_t::touchgesture_t(touch_gesture_type_t type, uint32_t direction
     this->finger_count = finger_count;
 }
 
-static const std::map<std::string, wf::touch_gesture_direction_t>
-touch_gesture_direction_string_map =
+/**
+ * The names of the swipe directions. The order determines the order in which
+ * the directions of a diagonal swipe are written by append_direction().
+ */
+static const struct
+{
+    const char *name;
+    wf::touch_gesture_direction_t direction;
+} touch_gesture_directions[] =
 {
-    {"up", wf::GESTURE_DIRECTION_UP},
     {"down", wf::GESTURE_DIRECTION_DOWN},
     {"left", wf::GESTURE_DIRECTION_LEFT},
-    {"right", wf::GESTURE_DIRECTION_RIGHT}
+    {"right", wf::GESTURE_DIRECTION_RIGHT},
+    {"up", wf::GESTURE_DIRECTION_UP},
 };
 
-static wf::touch_gesture_direction_t parse_single_direction(
-    const std::string& direction)
+/**
+ * Find the swipe direction with the given name.
+ * @return 0 if there is no such direction.
+ */
+static uint32_t parse_single_direction(const std::string& direction,
+    size_t start, size_t length)
 {
-    if (touch_gesture_direction_string_map.count(direction))
+    for (const auto& entry : touch_gesture_directions)
     {
-        return touch_gesture_direction_string_map.at(direction);
+        if (direction.compare(start, length, entry.name) == 0)
+        {
+            return entry.direction;
+        }
     }
 
-    throw std::domain_error("invalid swipe direction");
+    return 0;
 }
 
-uint32_t parse_direction(const std::string& direction)
+/**
+ * Parse a swipe direction, consisting of one or two direction names separated
+ * by a hyphen.
+ *
+ * @return false if the direction is invalid.
+ */
+static bool parse_direction(const std::string& direction, uint32_t& mask)
 {
-    size_t hyphen = direction.find("-");
+    size_t hyphen = direction.find('-');
     if (hyphen == std::string::npos)
     {
-        return parse_single_direction(direction);
-    } else
-    {
-        /* we support up to 2 directions, because >= 3 will be invalid anyway */
-        auto first  = direction.substr(0, hyphen);
-        auto second = direction.substr(hyphen + 1);
+        mask = parse_single_direction(direction, 0, direction.size());
+        return mask != 0;
+    }
 
-        uint32_t mask =
-            parse_single_direction(first) | parse_single_direction(second);
+    /* we support up to 2 directions, because >= 3 will be invalid anyway */
+    uint32_t first  = parse_single_direction(direction, 0, hyphen);
+    uint32_t second = parse_single_direction(direction, hyphen + 1,
+        std::string::npos);
+    if (!first || !second)
+    {
+        return false;
+    }
 
-        const uint32_t both_horiz =
-            wf::GESTURE_DIRECTION_LEFT | wf::GESTURE_DIRECTION_RIGHT;
-        const uint32_t both_vert =
-            wf::GESTURE_DIRECTION_UP | wf::GESTURE_DIRECTION_DOWN;
+    mask = first | second;
 
-        if (((mask & both_horiz) == both_horiz) ||
-            ((mask & both_vert) == both_vert))
-        {
-            throw std::domain_error("Cannot have two opposing directions in the"
-                                    "same gesture");
-        }
+    const uint32_t both_horiz =
+        wf::GESTURE_DIRECTION_LEFT | wf::GESTURE_DIRECTION_RIGHT;
+    const uint32_t both_vert =
+        wf::GESTURE_DIRECTION_UP | wf::GESTURE_DIRECTION_DOWN;
 
-        return mask;
-    }
+    /* Two opposing directions in the same swipe */
+    return ((mask & both_horiz) != both_horiz) &&
+           ((mask & both_vert) != both_vert);
 }
 
-wf::touchgesture_t parse_gesture(const std::string& value)
+/**
+ * Parse a gesture description of the form "<type> <direction> <fingers>".
+ * The disabled gestures "none" and "disabled" are not handled here.
+ *
+ * @param gesture Set to the parsed gesture if the description is valid.
+ * @return false if the description is invalid.
+ */
+static bool parse_gesture(const std::string& value,
+    wf::touchgesture_t& gesture)
 {
-    if (value.empty())
-    {
-        return {wf::GESTURE_TYPE_NONE, 0, 0};
-    }
-
-    auto tokens = split_at(value, " \t\v\b\n\r");
-    assert(!tokens.empty());
-
+    auto tokens = split_at(value, whitespace_chars);
     if (tokens.size() != 3)
     {
-        return {wf::GESTURE_TYPE_NONE, 0, 0};
+        return false;
     }
 
-    try {
-        wf::touch_gesture_type_t type;
-        uint32_t direction = 0;
-        int32_t finger_count;
+    wf::touch_gesture_type_t type;
+    uint32_t direction = 0;
 
-        if (tokens[0] == "pinch")
-        {
-            type = wf::GESTURE_TYPE_PINCH;
-            if (tokens[1] == "in")
-            {
-                direction = wf::GESTURE_DIRECTION_IN;
-            } else if (tokens[1] == "out")
-            {
-                direction = wf::GESTURE_DIRECTION_OUT;
-            } else
-            {
-                throw std::domain_error("Invalid pinch direction: " + tokens[1]);
-            }
-        } else if (tokens[0] == "swipe")
+    if (tokens[0] == "pinch")
+    {
+        type = wf::GESTURE_TYPE_PINCH;
+        if (tokens[1] == "in")
         {
-            type = wf::GESTURE_TYPE_SWIPE;
-            direction = parse_direction(tokens[1]);
-        } else if (tokens[0] == "edge-swipe")
+            direction = wf::GESTURE_DIRECTION_IN;
+        } else if (tokens[1] == "out")
         {
-            type = wf::GESTURE_TYPE_EDGE_SWIPE;
-            direction = parse_direction(tokens[1]);
+            direction = wf::GESTURE_DIRECTION_OUT;
         } else
         {
-            throw std::domain_error("Invalid gesture type:" + tokens[0]);
+            return false;
         }
+    } else if ((tokens[0] == "swipe") || (tokens[0] == "edge-swipe"))
+    {
+        type = (tokens[0] == "swipe") ?
+            wf::GESTURE_TYPE_SWIPE : wf::GESTURE_TYPE_EDGE_SWIPE;
+
+        if (!parse_direction(tokens[1], direction))
+        {
+            return false;
+        }
+    } else
+    {
+        return false;
+    }
 
-        // TODO: instead of atoi, check properly
-        finger_count = std::atoi(tokens[2].c_str());
-        return wf::touchgesture_t{type, direction, finger_count};
-    } catch (std::exception& e)
+    auto finger_count = wf::option_type::from_string<int>(tokens[2]);
+    if (!finger_count || (finger_count.value() <= 0))
     {
-        // XXX: show error?
-        // ignore it, will return GESTURE_NONE
+        return false;
     }
 
-    return wf::touchgesture_t{wf::GESTURE_TYPE_NONE, 0, 0};
+    gesture = wf::touchgesture_t{type, direction, finger_count.value()};
+    return true;
 }
 
 template<>
 stdx::optional<wf::touchgesture_t> wf::option_type::from_string(
     const std::string& description)
 {
-    auto as_binding = parse_binding(description);
-    if (as_binding && !as_binding.value().enabled)
+    auto descr_no_whitespace = filter_out(description, whitespace_chars);
+    if ((descr_no_whitespace == "none") || (descr_no_whitespace == "disabled"))
     {
         return touchgesture_t{GESTURE_TYPE_NONE, 0, 0};
     }
 
-    auto gesture = parse_gesture(description);
-    if (gesture.get_type() == GESTURE_TYPE_NONE)
+    touchgesture_t gesture{GESTURE_TYPE_NONE, 0, 0};
+    if (!parse_gesture(description, gesture))
     {
         return {};
     }
@@ -663,62 +848,65 @@ stdx::optional<wf::touchgesture_t> wf::option_type::from_string(
     return gesture;
 }
 
-static std::string direction_to_string(uint32_t direction)
+static void append_direction(std::string& out, uint32_t direction)
 {
-    std::string result = "";
-    for (auto& pair : touch_gesture_direction_string_map)
+    bool first = true;
+    for (const auto& entry : touch_gesture_directions)
     {
-        if (direction & pair.second)
+        if (direction & entry.direction)
         {
-            result += pair.first + "-";
-        }
-    }
+            if (!first)
+            {
+                out += '-';
+            }
 
-    if (result.size() > 0)
-    {
-        /* Remove trailing - */
-        result.pop_back();
+            out  += entry.name;
+            first = false;
+        }
     }
-
-    return result;
 }
 
 template<>
-std::string wf::option_type::to_string(const touchgesture_t& value)
+void wf::option_type::append_to(std::string& out, const touchgesture_t& value)
 {
-    std::string result;
     switch (value.get_type())
     {
       case GESTURE_TYPE_NONE:
-        return "";
+        return;
 
       case GESTURE_TYPE_EDGE_SWIPE:
-        result += "edge-";
+        out += "edge-";
 
       // fallthrough
       case GESTURE_TYPE_SWIPE:
-        result += "swipe ";
-        result += direction_to_string(value.get_direction()) + " ";
+        out += "swipe ";
+        append_direction(out, value.get_direction());
+        out += ' ';
         break;
 
       case GESTURE_TYPE_PINCH:
-        result += "pinch ";
+        out += "pinch ";
 
         if (value.get_direction() == GESTURE_DIRECTION_IN)
         {
-            result += "in ";
+            out += "in ";
         }
 
         if (value.get_direction() == GESTURE_DIRECTION_OUT)
         {
-            result += "out ";
+            out += "out ";
         }
 
         break;
     }
 
-    result += std::to_string(value.get_finger_count());
-    return result;
+    append_to<int>(out, value.get_finger_count());
+}
+
+template<>
+std::string wf::option_type::to_string(const touchgesture_t& value)
+{
+    return to_string_via_append(value);
 }
 
 wf::touch_gesture_type_t wf::touchgesture_t::get_type() const
@@ -758,9 +946,20 @@ wf::activatorbinding_t::activatorbinding_t()
 
 wf::activatorbinding_t::~activatorbinding_t() = default;
 
+/**
+ * Get the bindings of @binding. A moved-from binding has no impl and is
+ * treated as an empty binding.
+ */
+static const wf::activatorbinding_t::impl& get_bindings(
+    const wf::activatorbinding_t& binding)
+{
+    static const wf::activatorbinding_t::impl empty;
+    return binding.priv ? *binding.priv : empty;
+}
+
 wf::activatorbinding_t::activatorbinding_t(const activatorbinding_t& other)
 {
-    this->priv = std::make_unique<impl>(*other.priv);
+    this->priv = std::make_unique<impl>(get_bindings(other));
 }
 
 wf::activatorbinding_t& wf::activatorbinding_t::operator =(
@@ -768,17 +967,74 @@ wf::activatorbinding_t& wf::activatorbinding_t::operator =(
 {
     if (&other != this)
     {
-        this->priv = std::make_unique<impl>(*other.priv);
+        this->priv = std::make_unique<impl>(get_bindings(other));
     }
 
     return *this;
 }
 
+wf::activatorbinding_t::activatorbinding_t(activatorbinding_t&& other) noexcept =
+    default;
+wf::activatorbinding_t& wf::activatorbinding_t::operator =(
+    activatorbinding_t&& other) noexcept = default;
+
+static_assert(std::is_nothrow_move_constructible_v<wf::activatorbinding_t>,
+    "Vectors of activator bindings should move them on reallocation");
+
+/**
+ * The possible kinds of a single token in an activator description.
+ */
+enum activator_token_kind_t
+{
+    /* A keybinding, buttonbinding or none/disabled */
+    ACTIVATOR_TOKEN_BINDING,
+    /* [edge-]swipe or pinch gesture */
+    ACTIVATOR_TOKEN_GESTURE,
+    /* hotspot binding */
+    ACTIVATOR_TOKEN_HOTSPOT,
+};
+
+/**
+ * Determine the kind of an activator token by looking at its first word, so
+ * that it can be handed to exactly one parser.
+ */
+static activator_token_kind_t classify_activator_token(const std::string& token)
+{
+    size_t start = token.find_first_not_of(whitespace_chars);
+    if (start == std::string::npos)
+    {
+        return ACTIVATOR_TOKEN_BINDING;
+    }
+
+    size_t end = token.find_first_of(whitespace_chars, start);
+    if (end == std::string::npos)
+    {
+        end = token.size();
+    }
+
+    const auto& first_word_is = [&] (const char *word)
+    {
+        return token.compare(start, end - start, word) == 0;
+    };
+
+    if (first_word_is("hotspot"))
+    {
+        return ACTIVATOR_TOKEN_HOTSPOT;
+    }
+
+    if (first_word_is("swipe") || first_word_is("edge-swipe") ||
+        first_word_is("pinch"))
+    {
+        return ACTIVATOR_TOKEN_GESTURE;
+    }
+
+    return ACTIVATOR_TOKEN_BINDING;
+}
+
 template<class Type>
-bool try_add_binding(
-    std::vector<Type>& to, const std::string& value)
+static bool try_push_binding(std::vector<Type>& to,
+    const stdx::optional<Type>& binding)
 {
-    auto binding = wf::option_type::from_string<Type>(value);
     if (binding)
     {
         to.push_back(binding.value());
@@ -788,6 +1044,50 @@ bool try_add_binding(
     return false;
 }
 
+/**
+ * Parse a single token of an activator description and add it to @binding.
+ *
+ * @return false if the token is not a valid binding of any kind.
+ */
+static bool add_activator_token(wf::activatorbinding_t::impl& binding,
+    const std::string& token)
+{
+    switch (classify_activator_token(token))
+    {
+      case ACTIVATOR_TOKEN_HOTSPOT:
+        return try_push_binding(binding.hotspots,
+            wf::option_type::from_string<wf::hotspot_binding_t>(token));
+
+      case ACTIVATOR_TOKEN_GESTURE:
+      {
+        wf::touchgesture_t gesture{wf::GESTURE_TYPE_NONE, 0, 0};
+        if (!parse_gesture(token, gesture))
+        {
+            return false;
+        }
+
+        binding.gestures.push_back(gesture);
+        return true;
+      }
+
+      case ACTIVATOR_TOKEN_BINDING:
+      {
+        auto parsed = parse_binding(token);
+        if (!parsed)
+        {
+            return false;
+        }
+
+        auto as_key    = binding_as_key(parsed.value(), token);
+        auto as_button = binding_as_button(parsed.value(), token);
+        return try_push_binding(binding.keys, as_key) ||
+               try_push_binding(binding.buttons, as_button);
+      }
+    }
+
+    return false;
+}
+
 template<>
 stdx::optional<wf::activatorbinding_t> wf::option_type::from_string(
     const std::string& string)
@@ -802,13 +1102,7 @@ stdx::optional<wf::activatorbinding_t> wf::option_type::from_string(
     auto tokens = split_at(string, "|", true);
     for (auto& token : tokens)
     {
-        bool is_valid_binding =
-            try_add_binding(binding.priv->keys, token) ||
-            try_add_binding(binding.priv->buttons, token) ||
-            try_add_binding(binding.priv->gestures, token) ||
-            try_add_binding(binding.priv->hotspots, token);
-
-        if (!is_valid_binding)
+        if (!add_activator_token(*binding.priv, token))
         {
             return {};
         }
@@ -818,35 +1112,39 @@ stdx::optional<wf::activatorbinding_t> wf::option_type::from_string(
 }
 
 template<class Type>
-static std::string concatenate_bindings(const std::vector<Type>& bindings)
+static void append_bindings(std::string& out, const std::vector<Type>& bindings)
 {
-    std::string repr = "";
     for (auto& b : bindings)
     {
-        repr += wf::option_type::to_string<Type>(b);
-        repr += " | ";
+        wf::option_type::append_to<Type>(out, b);
+        out += " | ";
     }
-
-    return repr;
 }
 
 template<>
-std::string wf::option_type::to_string(
+void wf::option_type::append_to(std::string& out,
     const activatorbinding_t& value)
 {
-    std::string repr =
-        concatenate_bindings(value.priv->keys) +
-        concatenate_bindings(value.priv->buttons) +
-        concatenate_bindings(value.priv->gestures) +
-        concatenate_bindings(value.priv->hotspots);
+    const auto& bindings = get_bindings(value);
+
+    size_t start = out.size();
+    append_bindings(out, bindings.keys);
+    append_bindings(out, bindings.buttons);
+    append_bindings(out, bindings.gestures);
+    append_bindings(out, bindings.hotspots);
 
     /* Remove trailing " | " */
-    if (repr.size() >= 3)
+    if (out.size() - start >= 3)
     {
-        repr.erase(repr.size() - 3);
+        out.erase(out.size() - 3);
     }
+}
 
-    return repr;
+template<>
+std::string wf::option_type::to_string(
+    const activatorbinding_t& value)
+{
+    return to_string_via_append(value);
 }
 
 template<class Type>
@@ -858,31 +1156,33 @@ bool find_in_container(const std::vector<Type>& haystack,
 
 bool wf::activatorbinding_t::has_match(const keybinding_t& key) const
 {
-    return find_in_container(priv->keys, key);
+    return find_in_container(get_bindings(*this).keys, key);
 }
 
 bool wf::activatorbinding_t::has_match(const buttonbinding_t& button) const
 {
-    return find_in_container(priv->buttons, button);
+    return find_in_container(get_bindings(*this).buttons, button);
 }
 
 bool wf::activatorbinding_t::has_match(const touchgesture_t& gesture) const
 {
-    return find_in_container(priv->gestures, gesture);
+    return find_in_container(get_bindings(*this).gestures, gesture);
 }
 
 bool wf::activatorbinding_t::operator ==(const activatorbinding_t& other) const
 {
-    return priv->keys == other.priv->keys &&
-           priv->buttons == other.priv->buttons &&
-           priv->gestures == other.priv->gestures &&
-           priv->hotspots == other.priv->hotspots;
+    const auto& ours   = get_bindings(*this);
+    const auto& theirs = get_bindings(other);
+    return ours.keys == theirs.keys &&
+           ours.buttons == theirs.buttons &&
+           ours.gestures == theirs.gestures &&
+           ours.hotspots == theirs.hotspots;
 }
 
 const std::vector<wf::hotspot_binding_t>& wf::activatorbinding_t::get_hotspots()
 const
 {
-    return priv->hotspots;
+    return get_bindings(*this).hotspots;
 }
 
 wf::hotspot_binding_t::hotspot_binding_t(uint32_t edges,
@@ -986,11 +1286,10 @@ stdx::optional<wf::hotspot_binding_t> wf::option_type::from_string(
 }
 
 template<>
-std::string wf::option_type::to_string(
+void wf::option_type::append_to(std::string& out,
     const wf::hotspot_binding_t& value)
 {
-    std::ostringstream out;
-    out << "hotspot ";
+    out += "hotspot ";
 
     uint32_t remaining_edges = value.get_edges();
 
@@ -1003,10 +1302,10 @@ std::string wf::option_type::to_string(
                 remaining_edges &= ~edge.second;
                 if (need_hyphen)
                 {
-                    out << "-";
+                    out += '-';
                 }
 
-                out << edge.first;
+                out += edge.first;
                 break;
             }
         }
@@ -1015,10 +1314,19 @@ std::string wf::option_type::to_string(
     find_edge(false);
     find_edge(true);
 
-    out << " " << value.get_size_along_edge() << "x" <<
-        value.get_size_away_from_edge() <<
-        " " << value.get_timeout();
-    return out.str();
+    out += ' ';
+    append_to<int>(out, value.get_size_along_edge());
+    out += 'x';
+    append_to<int>(out, value.get_size_away_from_edge());
+    out += ' ';
+    append_to<int>(out, value.get_timeout());
+}
+
+template<>
+std::string wf::option_type::to_string(
+    const wf::hotspot_binding_t& value)
+{
+    return to_string_via_append(value);
 }
 
 /* ------------------------- Output config types ---------------------------- */
@@ -1150,35 +1458,44 @@ stdx::optional<wf::output_config::mode_t> wf::option_type::from_string(
     return wf::output_config::mode_t{w, h, rr};
 }
 
-/** Represent the activator binding as a string. */
 template<>
-std::string wf::option_type::to_string(const output_config::mode_t& value)
+void wf::option_type::append_to(std::string& out,
+    const output_config::mode_t& value)
 {
     switch (value.get_type())
     {
       case output_config::MODE_AUTO:
-        return "auto";
+        out += "auto";
+        break;
 
       case output_config::MODE_OFF:
-        return "off";
+        out += "off";
+        break;
 
       case output_config::MODE_RESOLUTION:
-        if (value.get_refresh() <= 0)
+        append_to<int>(out, value.get_width());
+        out += 'x';
+        append_to<int>(out, value.get_height());
+        if (value.get_refresh() > 0)
         {
-            return to_string(value.get_width()) + "x" +
-                   to_string(value.get_height());
-        } else
-        {
-            return to_string(value.get_width()) + "x" +
-                   to_string(value.get_height()) + "@" + to_string(
-                value.get_refresh());
+            out += '@';
+            append_to<int>(out, value.get_refresh());
         }
 
+        break;
+
       case output_config::MODE_MIRROR:
-        return "mirror " + value.get_mirror_from();
+        out += "mirror ";
+        out += value.get_mirror_from();
+        break;
     }
+}
 
-    return {};
+/** Represent the activator binding as a string. */
+template<>
+std::string wf::option_type::to_string(const output_config::mode_t& value)
+{
+    return to_string_via_append(value);
 }
 
 wf::output_config::position_t::position_t()
@@ -1242,14 +1559,24 @@ stdx::optional<wf::output_config::position_t> wf::option_type::from_string(
     return wf::output_config::position_t(x, y);
 }
 
-/** Represent the activator binding as a string. */
 template<>
-std::string wf::option_type::to_string(const output_config::position_t& value)
+void wf::option_type::append_to(std::string& out,
+    const output_config::position_t& value)
 {
     if (value.is_automatic_position())
     {
-        return "auto";
+        out += "auto";
+        return;
     }
 
-    return to_string(value.get_x()) + ", " + to_string(value.get_y());
+    append_to<int>(out, value.get_x());
+    out += ", ";
+    append_to<int>(out, value.get_y());
+}
+
+/** Represent the activator binding as a string. */
+template<>
+std::string wf::option_type::to_string(const output_config::position_t& value)
+{
+    return to_string_via_append(value);
 }
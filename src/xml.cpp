@@ -1,5 +1,6 @@
 #include <cstring>
 #include <wayfire/config/xml.hpp>
+#include <libxml/xmlreader.h>
 #include <wayfire/config/types.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/config/compound-option.hpp>
@@ -7,34 +8,62 @@
 #include "section-impl.hpp"
 #include "option-impl.hpp"
 
-static stdx::optional<const xmlChar*> extract_value(xmlNodePtr node,
-    std::string value_name)
+static stdx::optional<std::string> extract_value(xmlNodePtr node,
+    const char *value_name)
 {
-    stdx::optional<const xmlChar*> value_ptr;
+    stdx::optional<std::string> value;
 
     auto child_ptr = node->children;
     while (child_ptr != nullptr)
     {
         if ((child_ptr->type == XML_ELEMENT_NODE) &&
-            (std::string((const char*)child_ptr->name) == value_name))
+            xmlStrEqual(child_ptr->name, (const xmlChar*)value_name))
         {
             auto child_child_ptr = child_ptr->children;
             if (child_child_ptr == nullptr)
             {
-                value_ptr = (const xmlChar*)"";
+                value = "";
             } else if ((child_child_ptr->next == nullptr) &&
                        (child_child_ptr->type == XML_TEXT_NODE))
             {
-                value_ptr = child_child_ptr->content;
+                value = (const char*)child_child_ptr->content;
             }
         }
 
         child_ptr = child_ptr->next;
     }
 
-    return value_ptr;
+    return value;
 }
 
+/**
+ * The parts of an <option> element which are needed to create the option,
+ * independent of whether they were read from a document tree or a stream.
+ */
+struct option_description_t
+{
+    /* Location of the element, used for error messages */
+    const xmlChar *file;
+    int line;
+
+    std::string name;
+    std::string type;
+    stdx::optional<std::string> default_value;
+    stdx::optional<std::string> min_value;
+    stdx::optional<std::string> max_value;
+};
+
+/**
+ * An <entry> element of a dynamic-list option.
+ */
+struct entry_description_t
+{
+    int line;
+    stdx::optional<std::string> prefix;
+    stdx::optional<std::string> type;
+    std::string name;
+};
+
 /**
  * Create a new option of type T with the given name and default value.
  * @return The new option, or nullptr if the default value is invaild.
@@ -62,8 +91,8 @@ enum bounds_error_t
 template<class T>
 bounds_error_t set_bounds(
     std::shared_ptr<wf::config::option_base_t>& option,
-    stdx::optional<const xmlChar*> min_ptr,
-    stdx::optional<const xmlChar*> max_ptr)
+    const stdx::optional<std::string>& min_ptr,
+    const stdx::optional<std::string>& max_ptr)
 {
     if (!option)
     {
@@ -76,8 +105,7 @@ bounds_error_t set_bounds(
 
     if (min_ptr)
     {
-        auto value = wf::option_type::from_string<T>(
-            (const char*)min_ptr.value());
+        auto value = wf::option_type::from_string<T>(min_ptr.value());
         if (value)
         {
             typed_option->set_minimum(value.value());
@@ -90,7 +118,7 @@ bounds_error_t set_bounds(
     if (max_ptr)
     {
         stdx::optional<T> value = wf::option_type::from_string<T>(
-            (const char*)max_ptr.value());
+            max_ptr.value());
         if (value)
         {
             typed_option->set_maximum(value.value());
@@ -124,114 +152,122 @@ bounds_error_t set_bounds(
 template<class T>
 using entry_t = wf::config::compound_option_entry_t<T>;
 
-std::shared_ptr<wf::config::option_base_t> parse_compound_option(xmlNodePtr node,
-    const std::string& name)
+/**
+ * Create a dynamic-list option from the given description and entries.
+ * @return nullptr if any of the entries is invalid.
+ */
+static std::shared_ptr<wf::config::option_base_t> create_compound_option(
+    const option_description_t& desc, std::string type_hint,
+    const std::vector<entry_description_t>& entry_descs)
 {
     wf::config::compound_option_t::entries_t entries;
-    GET_OPTIONAL_XML_PROP(node, type_hint, "type-hint");
-
     if (not type_hint.size())
     {
         type_hint = "dict";
     }
 
-    node = node->children;
-    while (node)
+    for (auto& entry : entry_descs)
     {
-        if ((node->type == XML_ELEMENT_NODE) &&
-            ((const char*)node->name == std::string{"entry"}))
+        if (!entry.prefix || !entry.type)
         {
-            // Found next item
-            GET_XML_PROP_OR_BAIL(node, prefix, "prefix");
-            GET_XML_PROP_OR_BAIL(node, type, "type");
-            GET_OPTIONAL_XML_PROP(node, name, "name");
-
-            if (type == "int")
-            {
-                entries.push_back(std::make_unique<entry_t<int>>(prefix, name));
-            } else if (type == "double")
-            {
-                entries.push_back(std::make_unique<entry_t<double>>(prefix, name));
-            } else if (type == "bool")
-            {
-                entries.push_back(std::make_unique<entry_t<bool>>(prefix, name));
-            } else if (type == "string")
-            {
-                entries.push_back(std::make_unique<entry_t<std::string>>(prefix,
-                    name));
-            } else if (type == "key")
-            {
-                entries.push_back(std::make_unique<entry_t<wf::keybinding_t>>(prefix,
-                    name));
-            } else if (type == "button")
-            {
-                entries.push_back(std::make_unique<entry_t<wf::buttonbinding_t>>(
-                    prefix, name));
-            } else if (type == "gesture")
-            {
-                entries.push_back(std::make_unique<entry_t<wf::touchgesture_t>>(
-                    prefix, name));
-            } else if (type == "color")
-            {
-                entries.push_back(std::make_unique<entry_t<wf::color_t>>(prefix,
-                    name));
-            } else if (type == "activator")
-            {
-                entries.push_back(std::make_unique<entry_t<wf::activatorbinding_t>>(
-                    prefix, name));
-            } else
-            {
-                LOGE("Could not parse ", node->doc->URL,
-                    ": option at line ", node->line,
-                    " has invalid type \"", type, "\"");
-                return nullptr;
-            }
+            LOGE("Could not parse ", desc.file,
+                ": XML node at line ", entry.line, " is missing \"",
+                entry.prefix ? "type" : "prefix", "\" attribute.");
+            return nullptr;
         }
 
-        node = node->next;
+        const auto& prefix = entry.prefix.value();
+        const auto& type   = entry.type.value();
+        const auto& name   = entry.name;
+        if (type == "int")
+        {
+            entries.push_back(std::make_unique<entry_t<int>>(prefix, name));
+        } else if (type == "double")
+        {
+            entries.push_back(std::make_unique<entry_t<double>>(prefix, name));
+        } else if (type == "bool")
+        {
+            entries.push_back(std::make_unique<entry_t<bool>>(prefix, name));
+        } else if (type == "string")
+        {
+            entries.push_back(std::make_unique<entry_t<std::string>>(prefix,
+                name));
+        } else if (type == "key")
+        {
+            entries.push_back(std::make_unique<entry_t<wf::keybinding_t>>(prefix,
+                name));
+        } else if (type == "button")
+        {
+            entries.push_back(std::make_unique<entry_t<wf::buttonbinding_t>>(
+                prefix, name));
+        } else if (type == "gesture")
+        {
+            entries.push_back(std::make_unique<entry_t<wf::touchgesture_t>>(
+                prefix, name));
+        } else if (type == "color")
+        {
+            entries.push_back(std::make_unique<entry_t<wf::color_t>>(prefix,
+                name));
+        } else if (type == "activator")
+        {
+            entries.push_back(std::make_unique<entry_t<wf::activatorbinding_t>>(
+                prefix, name));
+        } else
+        {
+            LOGE("Could not parse ", desc.file,
+                ": option at line ", entry.line,
+                " has invalid type \"", type, "\"");
+            return nullptr;
+        }
     }
 
-    auto opt =
-        new wf::config::compound_option_t{name, std::move(entries), type_hint};
+    auto opt = new wf::config::compound_option_t{desc.name, std::move(entries),
+        type_hint};
     return std::shared_ptr<wf::config::option_base_t>(opt);
 }
 
-std::shared_ptr<wf::config::option_base_t> wf::config::xml::
-create_option_from_xml_node(xmlNodePtr node)
+std::shared_ptr<wf::config::option_base_t> parse_compound_option(xmlNodePtr node,
+    const option_description_t& desc)
 {
-    if ((node->type != XML_ELEMENT_NODE) ||
-        ((const char*)node->name != std::string{"option"}))
-    {
-        LOGE("Could not parse ", node->doc->URL,
-            ": line ", node->line, " is not an option element.");
-        return nullptr;
-    }
+    std::vector<entry_description_t> entries;
+    GET_OPTIONAL_XML_PROP(node, type_hint, "type-hint");
 
-    GET_XML_PROP_OR_BAIL(node, name, "name");
-    GET_XML_PROP_OR_BAIL(node, type, "type");
-    if (type == "dynamic-list")
+    node = node->children;
+    while (node)
     {
-        auto option = parse_compound_option(node, name);
-        if (option)
+        if ((node->type == XML_ELEMENT_NODE) &&
+            xmlStrEqual(node->name, (const xmlChar*)"entry"))
         {
-            option->priv->xml = node;
+            // Found next item
+            GET_XML_PROP_OR_BAIL(node, prefix, "prefix");
+            GET_XML_PROP_OR_BAIL(node, type, "type");
+            GET_OPTIONAL_XML_PROP(node, name, "name");
+            entries.push_back({node->line, prefix, type, name});
         }
 
-        return option;
+        node = node->next;
     }
 
-    auto default_value_ptr = extract_value(node, "default");
-    if (!default_value_ptr)
+    return create_compound_option(desc, type_hint, entries);
+}
+
+/**
+ * Create an option which is not a dynamic-list from the given description.
+ * Errors are printed to the log.
+ */
+static std::shared_ptr<wf::config::option_base_t> create_option_from_description(
+    const option_description_t& desc)
+{
+    const auto& name = desc.name;
+    const auto& type = desc.type;
+    if (!desc.default_value)
     {
-        LOGE("Could not parse ", node->doc->URL,
-            ": option at line ", node->line, " has no default value specified.");
+        LOGE("Could not parse ", desc.file,
+            ": option at line ", desc.line, " has no default value specified.");
         return nullptr;
     }
 
-    std::string default_value = (const char*)default_value_ptr.value();
-
-    auto min_value_ptr = extract_value(node, "min");
-    auto max_value_ptr = extract_value(node, "max");
+    const std::string& default_value = desc.default_value.value();
 
     std::shared_ptr<wf::config::option_base_t> option;
     bounds_error_t bounds_error = BOUNDS_OK;
@@ -240,12 +276,12 @@ create_option_from_xml_node(xmlNodePtr node)
     {
         option = create_option<int>(name, default_value);
         bounds_error = set_bounds<int>(option,
-            min_value_ptr, max_value_ptr);
+            desc.min_value, desc.max_value);
     } else if (type == "double")
     {
         option = create_option<double>(name, default_value);
         bounds_error = set_bounds<double>(option,
-            min_value_ptr, max_value_ptr);
+            desc.min_value, desc.max_value);
     } else if (type == "bool")
     {
         option = create_option<bool>(name, default_value);
@@ -275,8 +311,8 @@ create_option_from_xml_node(xmlNodePtr node)
         option = create_option<wf::output_config::position_t>(name, default_value);
     } else
     {
-        LOGE("Could not parse ", node->doc->URL,
-            ": option at line ", node->line,
+        LOGE("Could not parse ", desc.file,
+            ": option at line ", desc.line,
             " has invalid type \"", type, "\"");
         return nullptr;
     }
@@ -284,8 +320,8 @@ create_option_from_xml_node(xmlNodePtr node)
     if (!option)
     {
         /* This can only happen if default value was invalid */
-        LOGE("Could not parse ", node->doc->URL,
-            ": option at line ", node->line,
+        LOGE("Could not parse ", desc.file,
+            ": option at line ", desc.line,
             " has invalid default value \"", default_value, "\" for type ",
             type);
         return nullptr;
@@ -294,18 +330,18 @@ create_option_from_xml_node(xmlNodePtr node)
     switch (bounds_error)
     {
       case BOUNDS_INVALID_MINIMUM:
-        assert(min_value_ptr);
-        LOGE("Could not parse ", node->doc->URL,
-            ": option at line ", node->line,
-            " has invalid minimum value \"", min_value_ptr.value(), "\"",
+        assert(desc.min_value);
+        LOGE("Could not parse ", desc.file,
+            ": option at line ", desc.line,
+            " has invalid minimum value \"", desc.min_value.value(), "\"",
             "for type ", type);
         return nullptr;
 
       case BOUNDS_INVALID_MAXIMUM:
-        assert(max_value_ptr);
-        LOGE("Could not parse ", node->doc->URL,
-            ": option at line ", node->line,
-            " has invalid maximum value \"", max_value_ptr.value(), "\"",
+        assert(desc.max_value);
+        LOGE("Could not parse ", desc.file,
+            ": option at line ", desc.line,
+            " has invalid maximum value \"", desc.max_value.value(), "\"",
             "for type ", type);
         return nullptr;
 
@@ -313,7 +349,47 @@ create_option_from_xml_node(xmlNodePtr node)
         break;
     }
 
-    option->priv->xml = node;
+    return option;
+}
+
+std::shared_ptr<wf::config::option_base_t> wf::config::xml::
+create_option_from_xml_node(xmlNodePtr node)
+{
+    if ((node->type != XML_ELEMENT_NODE) ||
+        !xmlStrEqual(node->name, (const xmlChar*)"option"))
+    {
+        LOGE("Could not parse ", node->doc->URL,
+            ": line ", node->line, " is not an option element.");
+        return nullptr;
+    }
+
+    GET_XML_PROP_OR_BAIL(node, name, "name");
+    GET_XML_PROP_OR_BAIL(node, type, "type");
+
+    option_description_t desc;
+    desc.file = node->doc->URL;
+    desc.line = node->line;
+    desc.name = std::move(name);
+    desc.type = std::move(type);
+
+    std::shared_ptr<wf::config::option_base_t> option;
+    if (desc.type == "dynamic-list")
+    {
+        option = parse_compound_option(node, desc);
+    } else
+    {
+        desc.default_value = extract_value(node, "default");
+        desc.min_value     = extract_value(node, "min");
+        desc.max_value     = extract_value(node, "max");
+        option = create_option_from_description(desc);
+    }
+
+    if (option)
+    {
+        option->priv->xml = node;
+        option->priv->declared_in_xml = true;
+    }
+
     return option;
 }
 
@@ -324,7 +400,7 @@ static void recursively_parse_section_node(xmlNodePtr node,
     while (child_ptr != nullptr)
     {
         if ((child_ptr->type == XML_ELEMENT_NODE) &&
-            (std::string((const char*)child_ptr->name) == "option"))
+            xmlStrEqual(child_ptr->name, (const xmlChar*)"option"))
         {
             auto option = wf::config::xml::create_option_from_xml_node(
                 child_ptr);
@@ -335,13 +411,13 @@ static void recursively_parse_section_node(xmlNodePtr node,
         }
 
         if ((child_ptr->type == XML_ELEMENT_NODE) &&
-            (std::string((const char*)child_ptr->name) == "group"))
+            xmlStrEqual(child_ptr->name, (const xmlChar*)"group"))
         {
             recursively_parse_section_node(child_ptr, section);
         }
 
         if ((child_ptr->type == XML_ELEMENT_NODE) &&
-            (std::string((const char*)child_ptr->name) == "subgroup"))
+            xmlStrEqual(child_ptr->name, (const xmlChar*)"subgroup"))
         {
             recursively_parse_section_node(child_ptr, section);
         }
@@ -354,8 +430,8 @@ std::shared_ptr<wf::config::section_t> wf::config::xml::create_section_from_xml_
     xmlNodePtr node)
 {
     if ((node->type != XML_ELEMENT_NODE) ||
-        (((const char*)node->name != std::string{"plugin"}) &&
-         ((const char*)node->name != std::string{"object"})))
+        (!xmlStrEqual(node->name, (const xmlChar*)"plugin") &&
+         !xmlStrEqual(node->name, (const xmlChar*)"object")))
     {
         LOGE("Could not parse ", node->doc->URL,
             ": line ", node->line, " is not a plugin/object element.");
@@ -369,6 +445,288 @@ std::shared_ptr<wf::config::section_t> wf::config::xml::create_section_from_xml_
     return section;
 }
 
+/* ----------------- Streaming the options from an XML file ----------------- */
+static bool reader_at_element(xmlTextReaderPtr reader, const char *name)
+{
+    return (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) &&
+           xmlStrEqual(xmlTextReaderConstName(reader), (const xmlChar*)name);
+}
+
+static int reader_line(xmlTextReaderPtr reader)
+{
+    auto node = xmlTextReaderCurrentNode(reader);
+    return node ? node->line : xmlTextReaderGetParserLineNumber(reader);
+}
+
+static stdx::optional<std::string> reader_get_attribute(
+    xmlTextReaderPtr reader, const char *name)
+{
+    xmlChar *value = xmlTextReaderGetAttribute(reader, (const xmlChar*)name);
+    if (!value)
+    {
+        return {};
+    }
+
+    std::string result = (const char*)value;
+    xmlFree(value);
+    return result;
+}
+
+/**
+ * Advance the reader to the next node inside the element at @depth.
+ * @return false if the end of the element (or an error) was reached instead.
+ */
+static bool reader_next_child(xmlTextReaderPtr reader, int depth)
+{
+    return (xmlTextReaderRead(reader) == 1) &&
+           (xmlTextReaderDepth(reader) > depth);
+}
+
+/**
+ * Skip over the children of the element the reader is at.
+ */
+static void reader_skip_element(xmlTextReaderPtr reader)
+{
+    if (xmlTextReaderIsEmptyElement(reader))
+    {
+        return;
+    }
+
+    int depth = xmlTextReaderDepth(reader);
+    while (reader_next_child(reader, depth))
+    {}
+}
+
+/**
+ * Read the contents of the element the reader is at, with the same rules as
+ * extract_value(): the element has to be empty or contain a single text node.
+ */
+static stdx::optional<std::string> reader_read_value(xmlTextReaderPtr reader)
+{
+    if (xmlTextReaderIsEmptyElement(reader))
+    {
+        return std::string{};
+    }
+
+    int depth = xmlTextReaderDepth(reader);
+    int children = 0;
+    bool is_text = true;
+    std::string text;
+    while (reader_next_child(reader, depth))
+    {
+        int type = xmlTextReaderNodeType(reader);
+        if ((xmlTextReaderDepth(reader) != depth + 1) ||
+            (type == XML_READER_TYPE_END_ELEMENT))
+        {
+            continue;
+        }
+
+        ++children;
+        if ((type == XML_READER_TYPE_TEXT) ||
+            (type == XML_READER_TYPE_WHITESPACE) ||
+            (type == XML_READER_TYPE_SIGNIFICANT_WHITESPACE))
+        {
+            text = (const char*)xmlTextReaderConstValue(reader);
+        } else
+        {
+            is_text = false;
+        }
+    }
+
+    if (children == 0)
+    {
+        return std::string{};
+    }
+
+    if ((children == 1) && is_text)
+    {
+        return text;
+    }
+
+    return {};
+}
+
+static std::shared_ptr<wf::config::option_base_t> read_option(
+    xmlTextReaderPtr reader, const xmlChar *file)
+{
+    option_description_t desc;
+    desc.file = file;
+    desc.line = reader_line(reader);
+
+    auto name = reader_get_attribute(reader, "name");
+    auto type = reader_get_attribute(reader, "type");
+    if (!name || !type)
+    {
+        LOGE("Could not parse ", file, ": XML node at line ", desc.line,
+            " is missing \"", name ? "type" : "name", "\" attribute.");
+        reader_skip_element(reader);
+        return nullptr;
+    }
+
+    desc.name = std::move(name.value());
+    desc.type = std::move(type.value());
+    auto type_hint = reader_get_attribute(reader, "type-hint");
+
+    std::vector<entry_description_t> entries;
+    int depth = xmlTextReaderDepth(reader);
+    bool has_children = !xmlTextReaderIsEmptyElement(reader);
+    while (has_children && reader_next_child(reader, depth))
+    {
+        if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
+        {
+            continue;
+        }
+
+        if (reader_at_element(reader, "default"))
+        {
+            if (auto value = reader_read_value(reader))
+            {
+                desc.default_value = std::move(value);
+            }
+        } else if (reader_at_element(reader, "min"))
+        {
+            if (auto value = reader_read_value(reader))
+            {
+                desc.min_value = std::move(value);
+            }
+        } else if (reader_at_element(reader, "max"))
+        {
+            if (auto value = reader_read_value(reader))
+            {
+                desc.max_value = std::move(value);
+            }
+        } else
+        {
+            if (reader_at_element(reader, "entry"))
+            {
+                entries.push_back({reader_line(reader),
+                    reader_get_attribute(reader, "prefix"),
+                    reader_get_attribute(reader, "type"),
+                    reader_get_attribute(reader, "name").value_or("")});
+            }
+
+            reader_skip_element(reader);
+        }
+    }
+
+    std::shared_ptr<wf::config::option_base_t> option;
+    if (desc.type == "dynamic-list")
+    {
+        option = create_compound_option(desc, type_hint.value_or(""), entries);
+    } else
+    {
+        option = create_option_from_description(desc);
+    }
+
+    if (option)
+    {
+        option->priv->declared_in_xml = true;
+    }
+
+    return option;
+}
+
+/**
+ * Read the options in the plugin/object/group/subgroup element the reader is
+ * at, and add them to @section.
+ */
+static void read_section_options(xmlTextReaderPtr reader, const xmlChar *file,
+    wf::config::section_t& section)
+{
+    if (xmlTextReaderIsEmptyElement(reader))
+    {
+        return;
+    }
+
+    int depth = xmlTextReaderDepth(reader);
+    while (reader_next_child(reader, depth))
+    {
+        if (reader_at_element(reader, "option"))
+        {
+            if (auto option = read_option(reader, file))
+            {
+                section.register_new_option(option);
+            }
+        } else if (reader_at_element(reader, "group") ||
+                   reader_at_element(reader, "subgroup"))
+        {
+            read_section_options(reader, file, section);
+        } else if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT)
+        {
+            reader_skip_element(reader);
+        }
+    }
+}
+
+std::shared_ptr<wf::config::section_t> wf::config::xml::load_section_from_file(
+    const std::string& file)
+{
+    auto reader = xmlReaderForFile(file.c_str(), NULL, 0);
+    if (!reader)
+    {
+        LOGE("Failed to parse XML file ", file);
+        return nullptr;
+    }
+
+    const xmlChar *url = (const xmlChar*)file.c_str();
+    std::shared_ptr<section_t> section;
+
+    /* Seek the root element */
+    int ret;
+    while (((ret = xmlTextReaderRead(reader)) == 1) &&
+           (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT))
+    {}
+
+    if (ret != 1)
+    {
+        if (ret == 0)
+        {
+            LOGE(file, ": missing root element.");
+        }
+    } else if (!xmlTextReaderIsEmptyElement(reader))
+    {
+        /* Seek the plugin section */
+        while (reader_next_child(reader, 0))
+        {
+            if (!reader_at_element(reader, "plugin") &&
+                !reader_at_element(reader, "object"))
+            {
+                if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT)
+                {
+                    reader_skip_element(reader);
+                }
+
+                continue;
+            }
+
+            auto name = reader_get_attribute(reader, "name");
+            if (!name)
+            {
+                LOGE("Could not parse ", file, ": XML node at line ",
+                    reader_line(reader), " is missing \"name\" attribute.");
+                break;
+            }
+
+            section = std::make_shared<section_t>(name.value());
+            read_section_options(reader, url, *section);
+            break;
+        }
+    }
+
+    /* The rest of the file has to be valid as well */
+    while ((ret = xmlTextReaderRead(reader)) == 1)
+    {}
+
+    xmlFreeTextReader(reader);
+    if (ret < 0)
+    {
+        LOGE("Failed to parse XML file ", file);
+        return nullptr;
+    }
+
+    return section;
+}
+
 xmlNodePtr wf::config::xml::get_option_xml_node(
     std::shared_ptr<wf::config::option_base_t> option)
 {
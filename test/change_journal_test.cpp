@@ -0,0 +1,175 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/config/change-journal.hpp>
+#include <wayfire/config/compound-option.hpp>
+
+using namespace wf;
+using namespace wf::config;
+
+static std::shared_ptr<section_t> make_section(std::string name)
+{
+    auto section = std::make_shared<section_t>(name);
+    section->register_new_option(std::make_shared<option_t<int>>("IntOption", 1));
+    section->register_new_option(
+        std::make_shared<option_t<std::string>>("StringOption", "a"));
+    return section;
+}
+
+TEST_CASE("wf::config::change_journal_t")
+{
+    config_manager_t config{};
+    config.merge_section(make_section("Section"));
+    auto int_opt = config.get_option<int>("Section/IntOption");
+    auto str_opt = config.get_option<std::string>("Section/StringOption");
+
+    change_journal_t journal{config};
+    CHECK(!journal.can_undo());
+    CHECK(!journal.can_redo());
+    CHECK(!journal.undo());
+
+    int_opt->set_value(2);
+    int_opt->set_value(3);
+    str_opt->set_value("b");
+
+    CHECK(journal.undo());
+    CHECK(str_opt->get_value() == "a");
+    CHECK(int_opt->get_value() == 3);
+    CHECK(journal.undo());
+    CHECK(int_opt->get_value() == 2);
+    CHECK(journal.can_redo());
+    CHECK(journal.redo());
+    CHECK(int_opt->get_value() == 3);
+
+    SUBCASE("New changes drop undone changes")
+    {
+        int_opt->set_value(4);
+        CHECK(!journal.can_redo());
+        CHECK(journal.undo());
+        CHECK(int_opt->get_value() == 3);
+        CHECK(journal.undo());
+        CHECK(journal.undo());
+        CHECK(int_opt->get_value() == 1);
+        CHECK(!journal.undo());
+    }
+
+    SUBCASE("Transactions")
+    {
+        journal.begin_transaction();
+        int_opt->set_value(10);
+        journal.begin_transaction();
+        str_opt->set_value("c");
+        journal.end_transaction();
+        int_opt->set_value(11);
+        journal.end_transaction();
+        int_opt->set_value(12);
+
+        CHECK(journal.undo());
+        CHECK(int_opt->get_value() == 11);
+        CHECK(journal.undo());
+        CHECK(int_opt->get_value() == 3);
+        CHECK(str_opt->get_value() == "a");
+        CHECK(journal.redo());
+        CHECK(int_opt->get_value() == 11);
+        CHECK(str_opt->get_value() == "c");
+    }
+
+    SUBCASE("Clear")
+    {
+        journal.clear();
+        CHECK(!journal.can_undo());
+        CHECK(!journal.can_redo());
+        int_opt->set_value(5);
+        CHECK(journal.undo());
+        CHECK(int_opt->get_value() == 3);
+    }
+}
+
+TEST_CASE("wf::config::change_journal_t capacity")
+{
+    config_manager_t config{};
+    config.merge_section(make_section("Section"));
+    auto int_opt = config.get_option<int>("Section/IntOption");
+
+    change_journal_t journal{config, 3};
+    for (int i = 2; i <= 10; i++)
+    {
+        int_opt->set_value(i);
+    }
+
+    // Only the last three changes are remembered
+    CHECK(journal.undo());
+    CHECK(journal.undo());
+    CHECK(journal.undo());
+    CHECK(int_opt->get_value() == 7);
+    CHECK(!journal.undo());
+
+    CHECK(journal.redo());
+    int_opt->set_value(20);
+    journal.begin_transaction();
+    int_opt->set_value(21);
+    int_opt->set_value(22);
+    journal.end_transaction();
+
+    // The oldest transactions are dropped as a whole
+    CHECK(journal.undo());
+    CHECK(int_opt->get_value() == 20);
+    CHECK(journal.undo());
+    CHECK(int_opt->get_value() == 8);
+    CHECK(!journal.undo());
+
+    // A transaction which does not fit is never undone partially
+    journal.redo();
+    journal.redo();
+    auto str_opt = config.get_option<std::string>("Section/StringOption");
+    journal.begin_transaction();
+    for (int i = 30; i <= 34; i++)
+    {
+        int_opt->set_value(i);
+    }
+
+    str_opt->set_value("b");
+    journal.end_transaction();
+    CHECK(!journal.undo());
+    CHECK(int_opt->get_value() == 34);
+    CHECK(str_opt->get_value() == "b");
+
+    // Recording continues with the next transaction
+    int_opt->set_value(40);
+    CHECK(journal.undo());
+    CHECK(int_opt->get_value() == 34);
+}
+
+TEST_CASE("wf::config::change_journal_t watched options")
+{
+    config_manager_t config{};
+    auto section = make_section("Section");
+    compound_option_t::entries_t entries;
+    entries.push_back(std::make_unique<compound_option_entry_t<int>>("int_"));
+    auto list = std::make_shared<compound_option_t>("List", std::move(entries));
+    section->register_new_option(list);
+    config.merge_section(section);
+
+    auto journal = std::make_unique<change_journal_t>(config);
+
+    // Dynamic lists are not recorded
+    list->set_value(compound_list_t<int>{{"a", 1}});
+    CHECK(!journal->can_undo());
+
+    // Sections added later have to be watched explicitly
+    config.merge_section(make_section("Other"));
+    auto other = config.get_option<int>("Other/IntOption");
+    other->set_value(2);
+    CHECK(!journal->can_undo());
+    journal->watch_section(config.get_section("Other"));
+    journal->watch_section(config.get_section("Other"));
+    other->set_value(3);
+    CHECK(journal->undo());
+    CHECK(other->get_value() == 2);
+    CHECK(!journal->can_undo());
+
+    // Options are no longer watched once the journal is destroyed
+    journal.reset();
+    other->set_value(4);
+    CHECK(other->get_value() == 4);
+}
@@ -2,8 +2,15 @@
 #include <doctest/doctest.h>
 
 #include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
 #include <wayfire/config/config-manager.hpp>
 #include <wayfire/config/types.hpp>
+#include <wayfire/config/compound-option.hpp>
+#include <wayfire/util/log.hpp>
 
 TEST_CASE("wf::config::config_manager_t")
 {
@@ -88,3 +95,547 @@ TEST_CASE("wf::config::config_manager_t")
     REQUIRE(stored_int_opt);
     CHECK(stored_int_opt->get_value_str() == "6");
 }
+
+TEST_CASE("wf::config::config_manager_t::merge_section typed values")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    config_manager_t config{};
+
+    auto make_compound = [] ()
+    {
+        compound_option_t::entries_t entries;
+        entries.push_back(std::make_unique<compound_option_entry_t<int>>("int_"));
+        return std::make_shared<compound_option_t>("List", std::move(entries));
+    };
+
+    auto section = std::make_shared<section_t>("Section");
+    auto list    = make_compound();
+    auto int_opt = std::make_shared<option_t<int>>("IntOption", 1);
+    section->register_new_option(list);
+    section->register_new_option(int_opt);
+    config.merge_section(section);
+
+    auto overwrite = std::make_shared<section_t>("Section");
+    auto new_list  = make_compound();
+    new_list->set_value(compound_list_t<int>{{"a", 5}, {"b", 6}});
+    overwrite->register_new_option(new_list);
+    // Untyped options from a config file are applied as strings
+    overwrite->register_new_option(
+        std::make_shared<option_t<std::string>>("IntOption", "7"));
+    config.merge_section(overwrite);
+
+    CHECK(config.get_section("Section")->get_option("List") == list);
+    CHECK(list->get_value<int>() == compound_list_t<int>{{"a", 5}, {"b", 6}});
+    CHECK(int_opt->get_value() == 7);
+
+    CHECK(int_opt->assign_from(option_t<int>{"Other", 8}));
+    CHECK(int_opt->get_value() == 8);
+    CHECK(!int_opt->assign_from(option_t<double>{"Other", 9.0}));
+    CHECK(int_opt->get_value() == 8);
+
+    compound_option_t::entries_t double_entries;
+    double_entries.push_back(
+        std::make_unique<compound_option_entry_t<double>>("int_"));
+    compound_option_t double_list{"List", std::move(double_entries)};
+    CHECK(!list->assign_from(double_list));
+    CHECK(!list->assign_from(*int_opt));
+    CHECK(list->get_value<int>().size() == 2);
+}
+
+TEST_CASE("wf::config::config_manager_t section loaders")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    config_manager_t config{};
+
+    int loaded = 0;
+    auto make_section = [&] (std::string name, int value)
+    {
+        return [&loaded, name, value] ()
+        {
+            ++loaded;
+            auto section = std::make_shared<section_t>(name);
+            section->register_new_option(
+                std::make_shared<option_t<int>>("IntOption", value));
+            return section;
+        };
+    };
+
+    config.add_section_loader("First", make_section("First", 1));
+    config.add_section_loader("First", make_section("First", 2));
+    config.add_section_loader("Second", make_section("Second", 3));
+    config.add_section_loader("Missing", [] () { return nullptr; });
+    CHECK(config.get_all_sections().empty());
+
+    // Const lookups do not run loaders
+    const auto& const_config = config;
+    CHECK(const_config.get_option("First/IntOption") == nullptr);
+    CHECK(const_config.find_sections("*").empty());
+    CHECK(loaded == 0);
+
+    // Loaders run on first lookup, in order of registration
+    auto first = config.get_option<int>("First/IntOption");
+    REQUIRE(first);
+    CHECK(first->get_value() == 2);
+    CHECK(loaded == 2);
+    CHECK(config.get_section("First")->get_option("IntOption") == first);
+    CHECK(loaded == 2);
+    CHECK(config.get_all_sections().size() == 1);
+    CHECK(config.get_section("Missing") == nullptr);
+    CHECK(const_config.get_option<int>("First/IntOption") == first);
+
+    // Merged sections are applied on top of the loaded section
+    auto second = std::make_shared<section_t>("Second");
+    second->register_new_option(
+        std::make_shared<option_t<int>>("IntOption", 4));
+    config.merge_section(second);
+    CHECK(loaded == 3);
+    CHECK(config.get_option<int>("Second/IntOption")->get_value() == 4);
+    CHECK(config.get_section("Second") != second);
+
+    config.add_section_loader("Third", make_section("Third", 5));
+    config.load_all_sections();
+    CHECK(loaded == 4);
+    CHECK(config.get_all_sections().size() == 3);
+}
+
+TEST_CASE("wf::config::config_manager_t auto-persist")
+{
+    using namespace wf;
+    using namespace wf::config;
+    using namespace std::chrono_literals;
+
+    char path[] = "/tmp/wf-config-persist-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    auto read_file = [&] ()
+    {
+        std::ifstream in{path};
+        return std::string{std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+    };
+
+    auto make_section = [] (std::string name)
+    {
+        auto section = std::make_shared<section_t>(name);
+        section->register_new_option(
+            std::make_shared<option_t<int>>("IntOption", 1));
+        return section;
+    };
+
+    {
+        config_manager_t config{};
+        config.merge_section(make_section("First"));
+        config.enable_auto_persist(path, 1h);
+
+        auto first = config.get_option<int>("First/IntOption");
+        for (int i = 2; i <= 100; i++)
+        {
+            first->set_value(i);
+        }
+
+        // Nothing is written until the interval expires or a flush
+        CHECK(read_file() == "");
+        config.flush_auto_persist();
+        CHECK(read_file() == "[First]\nIntOption = 100\n\n");
+
+        // Sections merged later are watched as well
+        config.merge_section(make_section("Second"));
+        config.get_option<int>("Second/IntOption")->set_value(5);
+        first->set_value(6);
+    }
+
+    CHECK(read_file() ==
+        "[First]\nIntOption = 6\n\n[Second]\nIntOption = 5\n\n");
+
+    config_manager_t config{};
+    config.merge_section(make_section("Section"));
+    config.enable_auto_persist(path, 10ms);
+    config.get_option<int>("Section/IntOption")->set_value(3);
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while ((read_file() != "[Section]\nIntOption = 3\n\n") &&
+           (std::chrono::steady_clock::now() < deadline))
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    CHECK(read_file() == "[Section]\nIntOption = 3\n\n");
+
+    // Changes made without auto-persist are not saved
+    config.disable_auto_persist();
+    config.get_option<int>("Section/IntOption")->set_value(4);
+    config.flush_auto_persist();
+    CHECK(read_file() == "[Section]\nIntOption = 3\n\n");
+    unlink(path);
+}
+
+TEST_CASE("wf::config::config_manager_t queries")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    config_manager_t config{};
+    for (auto name : {"output", "output:DP-1", "output:HDMI-A-1", "outputs"})
+    {
+        auto section = std::make_shared<section_t>(name);
+        section->register_new_option(std::make_shared<option_t<int>>("mode", 1));
+        section->register_new_option(std::make_shared<option_t<int>>("scale", 1));
+        config.merge_section(section);
+    }
+
+    config.add_section_loader("output:eDP-1", [] ()
+    {
+        auto section = std::make_shared<section_t>("output:eDP-1");
+        section->register_new_option(std::make_shared<option_t<int>>("mode", 2));
+        return section;
+    });
+    config.add_section_loader("input", [] () { return nullptr; });
+
+    std::vector<std::string> names;
+    for (auto& section : config.find_sections("output:*"))
+    {
+        names.push_back(section->get_name());
+    }
+
+    CHECK(names ==
+        std::vector<std::string>{"output:DP-1", "output:HDMI-A-1",
+        "output:eDP-1"});
+    CHECK(config.find_sections("output").size() == 1);
+    CHECK(config.find_sections("nothing*").empty());
+
+    auto modes = config.find_options("output:*/mode");
+    REQUIRE(modes.size() == 3);
+    CHECK(modes[0] == config.get_option("output:DP-1/mode"));
+    CHECK(modes[2] == config.get_option("output:eDP-1/mode"));
+    CHECK(config.find_options("output*/*").size() == 9);
+    CHECK(config.find_options("output:DP-1/s*").size() == 1);
+    CHECK(config.find_options("output:*").empty());
+}
+
+TEST_CASE("wf::config::config_manager_t object instances")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    config_manager_t config{};
+    std::vector<std::pair<std::string, bool>> events;
+    config_manager_t::instance_callback_t handler =
+        [&] (const std::shared_ptr<section_t>& section, bool added)
+    {
+        events.push_back({section->get_name(), added});
+    };
+
+    config.add_instance_handler("output", &handler);
+    for (auto name : {"output", "output:DP-1", "input:kbd", "output:", ":x",
+        "output:HDMI-A-1"})
+    {
+        config.merge_section(std::make_shared<section_t>(name));
+    }
+
+    // Merging into an existing section does not add a new instance
+    config.merge_section(std::make_shared<section_t>("output:DP-1"));
+
+    auto& outputs = config.get_object_instances("output");
+    REQUIRE(outputs.size() == 2);
+    CHECK(outputs[0] == config.get_section("output:DP-1"));
+    CHECK(outputs[1] == config.get_section("output:HDMI-A-1"));
+    CHECK(config.get_object_instances("input").size() == 1);
+    CHECK(config.get_object_instances("window-rule").empty());
+    CHECK(events ==
+        std::vector<std::pair<std::string, bool>>{{"output:DP-1", true},
+        {"output:HDMI-A-1", true}});
+
+    config.remove_section("output:DP-1");
+    config.remove_section("output:DP-1");
+    CHECK(config.get_section("output:DP-1") == nullptr);
+    CHECK(outputs.size() == 1);
+    CHECK(events.back() == std::pair<std::string, bool>{"output:DP-1", false});
+
+    config.rem_instance_handler("output", &handler);
+    config.remove_section("output:HDMI-A-1");
+    CHECK(outputs.empty());
+    CHECK(events.size() == 3);
+
+    // Pending loaders are dropped together with the section
+    config.add_section_loader("output:eDP-1", [] ()
+    {
+        return std::make_shared<section_t>("output:eDP-1");
+    });
+    config.remove_section("output:eDP-1");
+    CHECK(config.get_section("output:eDP-1") == nullptr);
+}
+
+TEST_CASE("wf::config::config_manager_t auto-persist with removed sections")
+{
+    using namespace wf;
+    using namespace wf::config;
+    using namespace std::chrono_literals;
+
+    char path[] = "/tmp/wf-config-persist-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    auto read_file = [&] ()
+    {
+        std::ifstream in{path};
+        return std::string{std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+    };
+
+    config_manager_t config{};
+    auto core   = std::make_shared<section_t>("core");
+    auto output = std::make_shared<section_t>("output:DP-1");
+    auto option = std::make_shared<option_t<int>>("scale", 1);
+    core->register_new_option(std::make_shared<option_t<int>>("vwidth", 3));
+    output->register_new_option(option);
+    config.merge_section(core);
+    config.merge_section(output);
+    config.enable_auto_persist(path, 1h);
+
+    option->set_value(2);
+    config.flush_auto_persist();
+    CHECK(read_file() == "[core]\nvwidth = 3\n\n[output:DP-1]\nscale = 2\n\n");
+
+    // Removed sections are dropped and their options no longer watched
+    config.remove_section("output:DP-1");
+    config.flush_auto_persist();
+    option->set_value(3);
+    config.flush_auto_persist();
+    CHECK(read_file() == "[core]\nvwidth = 3\n\n");
+    unlink(path);
+}
+
+TEST_CASE("wf::config::config_manager_t notification queue")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    auto make_section = [] (std::string name)
+    {
+        auto section = std::make_shared<section_t>(name);
+        section->register_new_option(
+            std::make_shared<option_t<int>>("IntOption", 1));
+        return section;
+    };
+
+    config_manager_t config{};
+    config.merge_section(make_section("First"));
+    int fd = config.enable_notification_queue();
+    REQUIRE(fd >= 0);
+    config.merge_section(make_section("Second"));
+
+    auto first  = config.get_option<int>("First/IntOption");
+    auto second = config.get_option<int>("Second/IntOption");
+    std::vector<std::string> calls;
+    option_base_t::updated_callback_t on_first = [&] ()
+    {
+        calls.push_back("First " + std::to_string(first->get_value()));
+    };
+    option_base_t::updated_callback_t on_second = [&] ()
+    {
+        calls.push_back("Second " + std::to_string(second->get_value()));
+    };
+    first->add_updated_handler(&on_first);
+    second->add_updated_handler(&on_second);
+
+    auto readable = [&] ()
+    {
+        uint64_t count;
+        return read(fd, &count, sizeof(count)) == sizeof(count);
+    };
+
+    // Changes from the owner thread are notified right away
+    first->set_value(2);
+    CHECK(calls == std::vector<std::string>{"First 2"});
+    CHECK(!readable());
+
+    // Changes from other threads are coalesced until dispatched
+    calls.clear();
+    std::thread([&] ()
+    {
+        second->set_value(5);
+        first->set_value(3);
+        second->set_value(6);
+    }).join();
+    CHECK(calls.empty());
+    CHECK(readable());
+    config.dispatch_notifications();
+    CHECK(calls == std::vector<std::string>{"Second 6", "First 3"});
+    config.dispatch_notifications();
+    CHECK(calls.size() == 2);
+
+    calls.clear();
+    std::thread([&] { first->set_value(4); }).join();
+    config.remove_section("Second");
+    std::thread([&] { second->set_value(7); }).join();
+    CHECK(calls == std::vector<std::string>{"Second 7"});
+
+    // Pending notifications are dispatched when the queue is disabled
+    calls.clear();
+    config.disable_notification_queue();
+    CHECK(calls == std::vector<std::string>{"First 4"});
+    std::thread([&] { first->set_value(8); }).join();
+    CHECK(calls == std::vector<std::string>{"First 4", "First 8"});
+}
+
+TEST_CASE("wf::config::config_manager_t notification profile")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    config_manager_t config{};
+    auto section = std::make_shared<section_t>("core");
+    auto option  = std::make_shared<option_t<int>>("vwidth", 3);
+    section->register_new_option(option);
+    config.merge_section(section);
+
+    option_base_t::updated_callback_t handler = [] () {};
+    option->add_updated_handler(&handler);
+    option_base_t::set_profiling();
+    option->set_value(4);
+    option->set_value(5);
+    option_base_t::set_profiling(false);
+
+    std::stringstream out;
+    wf::log::initialize_logging(out, wf::log::LOG_LEVEL_DEBUG,
+        wf::log::LOG_COLOR_MODE_OFF);
+    config.log_notification_profile();
+    wf::log::initialize_logging(std::cout, wf::log::LOG_LEVEL_INFO,
+        wf::log::LOG_COLOR_MODE_OFF);
+
+    auto log = out.str();
+    CHECK(log.find("(1 handlers)") != std::string::npos);
+    CHECK(log.find("core/vwidth handler ") != std::string::npos);
+    CHECK(log.find(": 2 calls, total ") != std::string::npos);
+}
+
+TEST_CASE("wf::config::config_manager_t option IDs")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    config_manager_t config{};
+    auto make_section = [] (std::string name)
+    {
+        auto section = std::make_shared<section_t>(name);
+        section->register_new_option(std::make_shared<option_t<int>>("b", 1));
+        section->register_new_option(
+            std::make_shared<option_t<std::string>>("a", "str"));
+        return section;
+    };
+
+    config.merge_section(make_section("Second"));
+    config.add_section_loader("First", [&] () { return make_section("First"); });
+    const auto& const_config = config;
+    CHECK(const_config.get_option_id("Second/a") ==
+        config_manager_t::INVALID_OPTION_ID);
+
+    // IDs follow the section and option names, without loading sections
+    CHECK(config.assign_option_ids() == 2);
+    CHECK(config.get_option_id("Second/a") == 0);
+    CHECK(config.get_option_id("Second/b") == 1);
+    CHECK(config.get_option_id("Second/c") == config_manager_t::INVALID_OPTION_ID);
+    CHECK(const_config.get_option_id("First/a") ==
+        config_manager_t::INVALID_OPTION_ID);
+    CHECK(const_config.get_section("First") == nullptr);
+
+    // Sections loaded later get their IDs when they are merged
+    CHECK(config.get_option_id("First/b") == 3);
+    CHECK(config.get_option_id("First/a") == 2);
+    CHECK(config.get_option_by_id(0) == config.get_option("Second/a").get());
+    CHECK(config.get_option_by_id(4) == nullptr);
+    CHECK(config.get_option_by_id(config_manager_t::INVALID_OPTION_ID) == nullptr);
+
+    auto typed = config.get_option_id<int>("Second/b");
+    CHECK(typed.id == 1);
+    CHECK(config.get_option_id<int>("Second/a").id ==
+        config_manager_t::INVALID_OPTION_ID);
+    config.get_option<int>("Second/b")->set_value(5);
+    CHECK(config.get_option_by_id(typed)->get_value() == 5);
+
+    // Merged sections and options get new IDs, removed ones are not reused
+    config.merge_section(make_section("Third"));
+    CHECK(config.get_option_id("Third/a") == 4);
+    auto extra = std::make_shared<section_t>("Second");
+    extra->register_new_option(std::make_shared<option_t<int>>("c", 2));
+    config.merge_section(extra);
+    CHECK(config.get_option_id("Second/c") == 6);
+    config.remove_section("First");
+    CHECK(config.get_option_by_id(2) == nullptr);
+
+    // Options registered directly in a section get an ID on the next call
+    config.get_section("Third")->register_new_option(
+        std::make_shared<option_t<int>>("c", 3));
+    CHECK(config.get_option_id("Third/c") == config_manager_t::INVALID_OPTION_ID);
+    CHECK(config.assign_option_ids() == 8);
+    CHECK(config.get_option_id("Third/c") == 7);
+    CHECK(config.get_option_id("Second/b") == 1);
+
+    // Unregistered and replaced options lose their IDs
+    auto third = config.get_section("Third");
+    third->unregister_option(third->get_option("c"));
+    CHECK(config.get_option_by_id(7) == nullptr);
+    auto replacement = std::make_shared<option_t<int>>("b", 4);
+    third->register_new_option(replacement);
+    CHECK(config.get_option_by_id(5) == nullptr);
+    CHECK(config.get_option_id("Third/b") == config_manager_t::INVALID_OPTION_ID);
+    CHECK(config.assign_option_ids() == 9);
+    CHECK(config.get_option_by_id(8) == replacement.get());
+
+    // Options which leave another section keep their IDs
+    auto copy = std::make_shared<section_t>("Copy");
+    copy->register_new_option(replacement);
+    copy->unregister_option(replacement);
+    CHECK(config.get_option_id("Third/b") == 8);
+}
+
+TEST_CASE("wf::config::config_manager_t freeze")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    config_manager_t config{};
+    auto make_section = [] (std::string name)
+    {
+        auto section = std::make_shared<section_t>(name);
+        section->register_new_option(std::make_shared<option_t<int>>("a", 1));
+        return section;
+    };
+
+    config.merge_section(make_section("output:DP-1"));
+    config.merge_section(make_section("core"));
+    config.add_section_loader("output:DP-2",
+        [&] () { return make_section("output:DP-2"); });
+
+    config.freeze();
+    CHECK(config.is_frozen());
+    CHECK(config.get_section("core")->is_frozen());
+    CHECK(config.get_option("core/a") != nullptr);
+    CHECK(config.get_section("nonexistent") == nullptr);
+    CHECK(config.get_all_sections().size() == 2);
+
+    // Changing option values and merging into existing sections keeps the
+    // config manager frozen
+    auto update = std::make_shared<section_t>("core");
+    update->register_new_option(std::make_shared<option_t<int>>("a", 5));
+    config.merge_section(update);
+    CHECK(config.is_frozen());
+    CHECK(config.get_option<int>("core/a")->get_value() == 5);
+    CHECK(config.get_section("core")->is_frozen());
+
+    // Adding a section, here by running a loader, thaws it
+    CHECK(config.find_sections("output:*").size() == 2);
+    CHECK(!config.is_frozen());
+    CHECK(config.get_all_sections().size() == 3);
+
+    config.freeze();
+    config.remove_section("core");
+    CHECK(!config.is_frozen());
+    CHECK(config.get_section("core") == nullptr);
+}
@@ -4,12 +4,14 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/file.h>
+#include <sys/stat.h>
 #include <iostream>
 #include <fstream>
 
 #include <wayfire/config/file.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/config/types.hpp>
+#include <wayfire/config/xml.hpp>
 #include "wayfire/config/compound-option.hpp"
 #include "../src/option-impl.hpp"
 
@@ -151,6 +153,53 @@ TEST_CASE("wf::config::load_configuration_options_from_string - lock & reload")
     }
 }
 
+TEST_CASE("wf::config::config_stream_parser_t")
+{
+    std::stringstream log;
+    wf::log::initialize_logging(log, wf::log::LOG_LEVEL_DEBUG,
+        wf::log::LOG_COLOR_MODE_OFF);
+
+    using namespace wf;
+    using namespace wf::config;
+
+    config_manager_t batch;
+    load_configuration_options_from_string(batch, contents, "test");
+
+    // Split the source at every byte, so that every line, escape and
+    // continuation crosses a chunk boundary
+    config_manager_t config;
+    config_stream_parser_t parser{config, "test"};
+    for (auto& ch : contents)
+    {
+        parser.feed(&ch, 1);
+    }
+
+    // Complete lines are applied before finish()
+    REQUIRE(config.get_option("section1/option2"));
+    CHECK(config.get_option("section1/option2")->get_value_str() == "3");
+    parser.finish();
+
+    CHECK(save_configuration_options_to_string(config) ==
+        save_configuration_options_to_string(batch));
+    for (int i = 0; i < 2; i++)
+    {
+        EXPECT_LINE(log, "Error in file test:2");
+        EXPECT_LINE(log, "Error in file test:20");
+        EXPECT_LINE(log, "Error in file test:21");
+    }
+
+    // Options missing from the next source are reset on finish(), and a last
+    // line without a newline is applied as well
+    const std::string next = "[section2]\noption1 = a \\\nb";
+    parser.feed(next.data(), 14);
+    parser.feed(next.data() + 14, next.size() - 14);
+    CHECK(config.get_option("section1/option2")->get_value_str() == "3");
+    CHECK(config.get_option("section2/option1")->get_value_str() == "value 4 value");
+    parser.finish();
+    CHECK(config.get_option("section1/option2")->get_value_str() == "");
+    CHECK(config.get_option("section2/option1")->get_value_str() == "a b");
+}
+
 wf::config::config_manager_t build_simple_config()
 {
     using namespace wf;
@@ -221,7 +270,7 @@ TEST_CASE("wf::config::save_configuration_options_to_string - compound options e
     // However, make sure that XML-created options are saved even if they match
     // the prefix of a compound option.
     auto special_opt = std::make_shared<option_t<int>>("hey_you", 1);
-    special_opt->priv->xml = (xmlNode*)0x123;
+    special_opt->priv->declared_in_xml = true;
     section->register_new_option(special_opt);
 
     config_manager_t cfg;
@@ -242,6 +291,60 @@ hey_you = 1
     CHECK(str == expected);
 }
 
+TEST_CASE("wf::config::save_configuration_options - chunked output")
+{
+    using namespace wf::config;
+    auto config = build_simple_config();
+    for (int i = 0; i < 10; i++)
+    {
+        auto section = std::make_shared<section_t>("Big" + std::to_string(i));
+        for (int j = 0; j < 100; j++)
+        {
+            section->register_new_option(std::make_shared<option_t<std::string>>(
+                "option" + std::to_string(j), "value # " + std::to_string(j)));
+        }
+
+        config.merge_section(section);
+    }
+
+    auto expected = save_configuration_options_to_string(config);
+
+    std::vector<std::string> chunks;
+    save_configuration_options(config, [&] (const char *data, size_t size)
+    {
+        chunks.emplace_back(data, size);
+    });
+
+    REQUIRE(chunks.size() > 1);
+    std::string joined;
+    for (auto& chunk : chunks)
+    {
+        CHECK(chunk.size() < 2 * 4096);
+        CHECK(chunk.back() == '\n');
+        joined += chunk;
+    }
+
+    CHECK(joined == expected);
+
+    std::string test_config = std::string(TEST_SOURCE "/dummy.ini");
+    int fd = open(test_config.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(fd >= 0);
+    CHECK(save_configuration_options_to_fd(config, fd));
+    close(fd);
+    CHECK(!save_configuration_options_to_fd(config, -1));
+
+    save_configuration_to_file(config, test_config + ".2");
+    for (auto file : {test_config, test_config + ".2"})
+    {
+        std::ifstream infile(file);
+        std::string file_contents((std::istreambuf_iterator<char>(infile)),
+            std::istreambuf_iterator<char>());
+        CHECK(file_contents == expected);
+    }
+
+    unlink((test_config + ".2").c_str());
+}
+
 TEST_CASE("wf::config::load_configuration_options_from_file - no such file")
 {
     std::string test_config = std::string("FileDoesNotExist");
@@ -338,6 +441,68 @@ TEST_CASE("wf::config::save_configuration_to_file - success")
     close(fd);
 }
 
+TEST_CASE("wf::config::save_configuration_to_file - replacing the file")
+{
+    std::stringstream log;
+    wf::log::initialize_logging(log, wf::log::LOG_LEVEL_DEBUG,
+        wf::log::LOG_COLOR_MODE_OFF);
+
+    char dir[] = "/tmp/wf-config-save-XXXXXX";
+    REQUIRE(mkdtemp(dir) != nullptr);
+    std::string target = std::string(dir) + "/target.ini";
+    std::string link   = std::string(dir) + "/link.ini";
+    std::string tmp    = target + ".tmp-" + std::to_string(getpid());
+
+    auto read_file = [] (const std::string& file)
+    {
+        std::ifstream infile(file);
+        return std::string((std::istreambuf_iterator<char>(infile)),
+            std::istreambuf_iterator<char>());
+    };
+
+    std::ofstream{target} << "Dummy";
+    chmod(target.c_str(), 0640);
+    REQUIRE(symlink(target.c_str(), link.c_str()) == 0);
+
+    // The file stays untouched if the temporary file cannot be written
+    REQUIRE(mkdir(tmp.c_str(), 0700) == 0);
+    wf::config::save_configuration_to_file(build_simple_config(), link,
+        wf::config::CONFIG_SAVE_REPLACE);
+    CHECK(read_file(target) == "Dummy");
+    EXPECT_LINE(log, "Failed to open " + tmp);
+    rmdir(tmp.c_str());
+
+    // The symlink is kept, and its target is replaced with the same mode
+    struct stat st;
+    REQUIRE(stat(target.c_str(), &st) == 0);
+    auto old_inode = st.st_ino;
+    wf::config::save_configuration_to_file(build_simple_config(), link,
+        wf::config::CONFIG_SAVE_REPLACE);
+    REQUIRE(lstat(link.c_str(), &st) == 0);
+    CHECK(S_ISLNK(st.st_mode));
+    REQUIRE(stat(target.c_str(), &st) == 0);
+    CHECK((st.st_mode & 07777) == 0640);
+    CHECK(st.st_ino != old_inode);
+    CHECK(read_file(target) == simple_config_source);
+    CHECK(access(tmp.c_str(), F_OK) != 0);
+
+    // By default, the file is written in place, keeping hard links intact
+    std::string hardlink = std::string(dir) + "/hardlink.ini";
+    REQUIRE(::link(target.c_str(), hardlink.c_str()) == 0);
+    std::ofstream{target} << "Dummy";
+    wf::config::save_configuration_to_file(build_simple_config(), hardlink);
+    CHECK(read_file(target) == simple_config_source);
+    struct stat hardlink_st;
+    REQUIRE(stat(hardlink.c_str(), &hardlink_st) == 0);
+    REQUIRE(stat(target.c_str(), &st) == 0);
+    CHECK(st.st_ino == hardlink_st.st_ino);
+
+    unlink(hardlink.c_str());
+    unlink(link.c_str());
+    unlink(target.c_str());
+    rmdir(dir);
+}
+
 TEST_CASE("wf::config::build_configuration")
 {
     wf::log::initialize_logging(std::cout, wf::log::LOG_LEVEL_DEBUG,
@@ -372,6 +537,7 @@ TEST_CASE("wf::config::build_configuration")
     CHECK(o4->get_value_str() == "DoesNotExistInConfig");
     CHECK(o5->get_value_str() == "Option5Sys");
     CHECK(o6->get_value_str() == "10"); // bounds from xml applied
+    CHECK(config.get_object_instances("sectionobj").size() == 1);
 
     o1->reset_to_default();
     o2->reset_to_default();
@@ -387,3 +553,160 @@ TEST_CASE("wf::config::build_configuration")
     CHECK(o5->get_value_str() == "Option5Sys");
     CHECK(o6->get_value_str() == "1");
 }
+
+TEST_CASE("wf::config::build_configuration - XML on demand")
+{
+    std::string xmldir = std::string(TEST_SOURCE "/int_test/xml");
+    std::vector xmldirs(1, xmldir);
+    using namespace wf::config;
+
+    SUBCASE("Sections from config files are loaded")
+    {
+        std::string sysconf  = std::string(TEST_SOURCE "/int_test/sys.ini");
+        std::string userconf = std::string(TEST_SOURCE "/int_test/config.ini");
+        auto config = build_configuration(xmldirs, sysconf, userconf,
+            XML_LOAD_ON_DEMAND);
+        CHECK(config.get_all_sections().size() == 4);
+        check_int_test_config(config, "10");
+
+        auto o5 = config.get_option("section2/option5");
+        auto o6 = config.get_option("sectionobj:objtest/option6");
+        REQUIRE(o5);
+        REQUIRE(o6);
+        CHECK(o5->get_value_str() == "Option5Sys");
+        CHECK(o6->get_value_str() == "10");
+    }
+
+    SUBCASE("Streamed XML files")
+    {
+        std::string sysconf  = std::string(TEST_SOURCE "/int_test/sys.ini");
+        std::string userconf = std::string(TEST_SOURCE "/int_test/config.ini");
+        auto config = build_configuration(xmldirs, sysconf, userconf,
+            XML_LOAD_ON_DEMAND_STREAMING);
+        check_int_test_config(config, "10");
+        CHECK(xml::get_section_xml_node(config.get_section("section1")) ==
+            nullptr);
+    }
+
+    SUBCASE("Other sections are loaded on first use")
+    {
+        auto config = build_configuration(xmldirs, "/does/not/exist",
+            "/does/not/exist", XML_LOAD_ON_DEMAND);
+        CHECK(config.get_all_sections().empty());
+
+        auto o2 = config.get_option("section2/option2");
+        REQUIRE(o2);
+        CHECK(o2->get_value_str() == "XMLDefault");
+        CHECK(config.get_all_sections().size() == 1);
+        CHECK(config.get_section("section1") != nullptr);
+        CHECK(config.get_all_sections().size() == 2);
+    }
+}
+
+TEST_CASE("wf::config::build_configuration - streamed XML and compound options")
+{
+    char dir[] = "/tmp/wf-config-xmldir-XXXXXX";
+    REQUIRE(mkdtemp(dir) != nullptr);
+    std::string xmlfile  = std::string(dir) + "/binding.xml";
+    std::string userconf = std::string(dir) + "/config.ini";
+
+    std::ofstream{xmlfile} << R"(<?xml version="1.0"?>
+<wayfire>
+<plugin name="binding">
+    <option name="binding_left" type="string"><default>L</default></option>
+    <option name="bindings" type="dynamic-list">
+        <entry prefix="binding_" type="string"/>
+    </option>
+</plugin>
+</wayfire>
+)";
+    std::ofstream{userconf} << "[binding]\nbinding_left = LL\nbinding_up = UU\n";
+
+    using namespace wf::config;
+    std::vector<std::string> xmldirs(1, dir);
+    auto from_tree   = build_configuration(xmldirs, "", userconf);
+    auto from_stream = build_configuration(xmldirs, "", userconf,
+        XML_LOAD_STREAMING);
+
+    // The option declared in XML is not an entry of the list with both loaders
+    for (auto config : {&from_tree, &from_stream})
+    {
+        auto list = std::dynamic_pointer_cast<compound_option_t>(
+            config->get_option("binding/bindings"));
+        REQUIRE(list);
+        CHECK(list->get_value<std::string>() ==
+            compound_list_t<std::string>{{"up", "UU"}});
+        CHECK(config->get_option("binding/binding_left")->get_value_str() == "LL");
+    }
+
+    auto saved = save_configuration_options_to_string(from_stream);
+    CHECK(saved == save_configuration_options_to_string(from_tree));
+    CHECK(saved.find("binding_left = LL") != std::string::npos);
+
+    unlink(xmlfile.c_str());
+    unlink(userconf.c_str());
+    rmdir(dir);
+}
+
+TEST_CASE("wf::config::config_schema_t")
+{
+    std::string xmldir   = std::string(TEST_SOURCE "/int_test/xml");
+    std::string sysconf  = std::string(TEST_SOURCE "/int_test/sys.ini");
+    std::string userconf = std::string(TEST_SOURCE "/int_test/config.ini");
+    std::vector xmldirs(1, xmldir);
+    using namespace wf::config;
+
+    auto schema = std::make_unique<config_schema_t>(xmldirs, sysconf);
+    auto config = build_configuration(*schema, userconf);
+    auto fresh  = schema->create_configuration();
+    schema.reset();
+
+    // The configuration is the same as without a schema
+    check_int_test_config(config, "10");
+    auto o5 = config.get_option("section2/option5");
+    auto o6 = config.get_option("sectionobj:objtest/option6");
+    REQUIRE(o5);
+    REQUIRE(o6);
+    CHECK(o5->get_value_str() == "Option5Sys");
+    CHECK(o6->get_value_str() == "10");
+    CHECK(xml::get_option_xml_node(o6) != nullptr);
+    o6->reset_to_default();
+    CHECK(o6->get_value_str() == "1");
+
+    // Configurations do not share options, and only copy what they use
+    CHECK(fresh.get_all_sections().empty());
+    auto fresh_o1 = fresh.get_option("section1/option1");
+    REQUIRE(fresh_o1);
+    CHECK(fresh_o1 != config.get_option("section1/option1"));
+    CHECK(fresh_o1->get_value_str() == "4");
+    CHECK(fresh.get_all_sections().size() == 1);
+    CHECK(fresh.get_section("sectionobj:objtest") == nullptr);
+}
+
+TEST_CASE("wf::config::build_configuration - system defaults diagnostics")
+{
+    std::stringstream log;
+    wf::log::initialize_logging(log, wf::log::LOG_LEVEL_DEBUG,
+        wf::log::LOG_COLOR_MODE_OFF);
+
+    std::string xmldir   = std::string(TEST_SOURCE "/int_test/xml");
+    std::string sysconf  = std::string(TEST_SOURCE "/int_test/sys_unused.ini");
+    std::string userconf = std::string(TEST_SOURCE "/int_test/config.ini");
+
+    std::vector xmldirs(1, xmldir);
+    auto config = wf::config::build_configuration(xmldirs, sysconf, userconf);
+
+    auto o1 = config.get_option("section1/option1");
+    auto o5 = config.get_option("section2/option5");
+    REQUIRE(o1);
+    REQUIRE(o5);
+    CHECK(o1->get_default_value_str() == "4");
+    CHECK(o5->get_value_str() == "Option5Sys");
+
+    EXPECT_LINE(log, "Invalid value for section1/option1");
+    log.clear();
+    log.seekg(0);
+    EXPECT_LINE(log,
+        "Unused default values in " + sysconf +
+        ": section2/nonexistent, nosection/option");
+}
@@ -0,0 +1,158 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/config/ipc-server.hpp>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace wf::config;
+
+static int connect_to(const std::string& path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    REQUIRE(connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+static void send_frame(int fd, const std::string& payload)
+{
+    uint32_t size = payload.size();
+    std::string frame((const char*)&size, sizeof(size));
+    frame += payload;
+    REQUIRE(write(fd, frame.data(), frame.size()) == (ssize_t)frame.size());
+}
+
+static std::string read_frame(int fd)
+{
+    uint32_t size;
+    REQUIRE(recv(fd, &size, sizeof(size), MSG_WAITALL) == sizeof(size));
+    std::string payload(size, '\0');
+    if (size > 0)
+    {
+        REQUIRE(recv(fd, &payload[0], size, MSG_WAITALL) == (ssize_t)size);
+    }
+
+    return payload;
+}
+
+TEST_CASE("wf::config::ipc_server_t")
+{
+    config_manager_t config{};
+    auto section = std::make_shared<section_t>("Section");
+    section->register_new_option(std::make_shared<option_t<int>>("IntOption", 1));
+    section->register_new_option(
+        std::make_shared<option_t<std::string>>("StringOption", "a b"));
+    config.merge_section(section);
+    auto int_opt = config.get_option<int>("Section/IntOption");
+
+    std::string path = "/tmp/wf-config-ipc-" + std::to_string(getpid());
+    ipc_server_t server{config, path};
+    CHECK(server.get_fd() >= 0);
+
+    int client = connect_to(path);
+    server.dispatch();
+
+    SUBCASE("Batched get and set")
+    {
+        send_frame(client,
+            "get Section/IntOption\n"
+            "get Section/StringOption\n"
+            "set Section/IntOption 5\n"
+            "set Section/StringOption c d\n"
+            "set Section/IntOption x\n"
+            "get Section/Missing\n"
+            "frobnicate Section/IntOption\n");
+        server.dispatch();
+        CHECK(read_frame(client) ==
+            "ok 1\n"
+            "ok a b\n"
+            "ok\n"
+            "ok\n"
+            "error invalid value\n"
+            "error no such option\n"
+            "error unknown command\n");
+        CHECK(int_opt->get_value() == 5);
+        CHECK(config.get_option("Section/StringOption")->get_value_str() == "c d");
+    }
+
+    SUBCASE("Subscriptions")
+    {
+        int other = connect_to(path);
+        server.dispatch();
+
+        send_frame(client, "subscribe Section/IntOption");
+        server.dispatch();
+        CHECK(read_frame(client) == "ok 1\n");
+
+        int_opt->set_value(2);
+        CHECK(read_frame(client) == "changed Section/IntOption 2\n");
+
+        // Changes made by other clients are pushed as well
+        send_frame(other, "set Section/IntOption 3\n");
+        server.dispatch();
+        CHECK(read_frame(other) == "ok\n");
+        CHECK(read_frame(client) == "changed Section/IntOption 3\n");
+
+        // The client's own changes are pushed after the response
+        send_frame(client, "set Section/IntOption 6\nget Section/IntOption\n");
+        server.dispatch();
+        CHECK(read_frame(client) == "ok\nok 6\n");
+        CHECK(read_frame(client) == "changed Section/IntOption 6\n");
+        int_opt->set_value(3);
+        CHECK(read_frame(client) == "changed Section/IntOption 3\n");
+
+        send_frame(client, "unsubscribe Section/IntOption\nget Section/IntOption");
+        server.dispatch();
+        CHECK(read_frame(client) == "ok\nok 3\n");
+        int_opt->set_value(4);
+
+        // A subscribed client which disconnects is removed
+        send_frame(other, "subscribe Section/IntOption\n");
+        server.dispatch();
+        CHECK(read_frame(other) == "ok 4\n");
+        close(other);
+        server.dispatch();
+        int_opt->set_value(5);
+
+        send_frame(client, "get Section/IntOption\n");
+        server.dispatch();
+        CHECK(read_frame(client) == "ok 5\n");
+    }
+
+    SUBCASE("Frames split across writes")
+    {
+        std::string request = "get Section/IntOption\n";
+        uint32_t size = request.size();
+        REQUIRE(write(client, &size, 2) == 2);
+        server.dispatch();
+        REQUIRE(write(client, (char*)&size + 2, 2) == 2);
+        REQUIRE(write(client, request.data(), 5) == 5);
+        server.dispatch();
+        REQUIRE(write(client, request.data() + 5, request.size() - 5) ==
+            (ssize_t)request.size() - 5);
+        server.dispatch();
+        CHECK(read_frame(client) == "ok 1\n");
+    }
+
+    SUBCASE("Too large frames")
+    {
+        uint32_t size = 1 << 30;
+        REQUIRE(write(client, &size, sizeof(size)) == sizeof(size));
+        server.dispatch();
+        char c;
+        CHECK(read(client, &c, 1) == 0);
+    }
+
+    close(client);
+}
+
+TEST_CASE("wf::config::ipc_server_t invalid socket")
+{
+    config_manager_t config{};
+    CHECK_THROWS(ipc_server_t(config, "/does/not/exist/socket"));
+}
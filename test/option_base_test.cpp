@@ -1,6 +1,7 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 #include <wayfire/config/option.hpp>
+#include <thread>
 
 class option_base_stub_t : public wf::config::option_base_t
 {
@@ -85,3 +86,42 @@ TEST_CASE("wf::option_base_t")
     option.set_locked(false);
     CHECK(option.is_locked() == false);
 }
+
+TEST_CASE("wf::option_base_t handler profiling")
+{
+    using profile_t = wf::config::option_base_t::handler_profile_t;
+    option_base_stub_t option{"string"};
+
+    wf::config::option_base_t::updated_callback_t fast, slow;
+    fast = [&] () {};
+    slow = [&] () { std::this_thread::sleep_for(std::chrono::milliseconds(2)); };
+    option.add_updated_handler(&fast);
+    option.add_updated_handler(&slow);
+
+    // Nothing is recorded while profiling is disabled
+    CHECK(!wf::config::option_base_t::is_profiling());
+    option.notify_updated();
+    CHECK(option.get_handler_profile().empty());
+
+    wf::config::option_base_t::set_profiling();
+    option.notify_updated();
+    option.notify_updated();
+    wf::config::option_base_t::set_profiling(false);
+    option.notify_updated();
+
+    auto profile = option.get_handler_profile();
+    REQUIRE(profile.size() == 2);
+    CHECK(profile[0].handler == &fast);
+    CHECK(profile[1].handler == &slow);
+    for (const profile_t& entry : profile)
+    {
+        CHECK(entry.calls == 2);
+        CHECK(entry.max <= entry.total);
+    }
+
+    CHECK(profile[1].max >= std::chrono::milliseconds(2));
+    CHECK(profile[1].total >= std::chrono::milliseconds(4));
+
+    option.reset_handler_profile();
+    CHECK(option.get_handler_profile().empty());
+}
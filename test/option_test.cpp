@@ -4,8 +4,10 @@
 #include <wayfire/config/option.hpp>
 #include <wayfire/config/compound-option.hpp>
 #include <wayfire/config/types.hpp>
+#include <wayfire/config/xml.hpp>
 #include <linux/input-event-codes.h>
 #include <algorithm>
+#include <thread>
 #include "../src/option-impl.hpp"
 
 /**
@@ -103,6 +105,14 @@ TEST_CASE("wf::config::option_t<unboundable>")
     clone->set_value_str("<super>KEY_F");
     CHECK(callback_called == 1);
     CHECK(clone_callback_called == 1);
+
+    // Setting an rvalue behaves like setting a copy
+    callback_called = 0;
+    opt.set_value(wf::keybinding_t{binding2});
+    CHECK(opt.get_value() == binding2);
+    CHECK(callback_called == 1);
+    opt.set_value(wf::keybinding_t{binding2});
+    CHECK(callback_called == 1);
 }
 
 TEST_CASE("wf::config::option_t<boundable>")
@@ -168,6 +178,56 @@ TEST_CASE("wf::config::option_t<boundable>")
     CHECK(are_bounds_enabled<option_t<double>>::value);
 }
 
+TEST_CASE("wf::config::option_t atomic reads")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    option_t<int> iopt{"int123", 5};
+    iopt.enable_atomic_reads();
+    CHECK(iopt.get_value_atomic() == 5);
+    iopt.set_minimum(7);
+    CHECK(iopt.get_value_atomic() == 7);
+    iopt.set_value_str("9");
+    CHECK(iopt.get_value_atomic() == 9);
+    auto iclone = std::static_pointer_cast<option_t<int>>(iopt.clone_option());
+    CHECK(iclone->get_value_atomic() == 9);
+
+    option_t<keybinding_t> kopt{"key", keybinding_t{0, KEY_A}};
+    kopt.enable_atomic_reads();
+    kopt.set_value(keybinding_t{KEYBOARD_MODIFIER_ALT, KEY_B});
+    CHECK(kopt.get_value_atomic() == keybinding_t{KEYBOARD_MODIFIER_ALT, KEY_B});
+
+    // Larger values are never read torn
+    option_t<color_t> copt{"color", color_t{0, 0, 0, 0}};
+    copt.enable_atomic_reads();
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::thread reader([&] ()
+    {
+        while (!done)
+        {
+            auto color = copt.get_value_atomic();
+            if ((color.r != color.g) || (color.r != color.b) ||
+                (color.r != color.a))
+            {
+                ++torn;
+            }
+        }
+    });
+
+    for (int i = 1; i <= 100000; i++)
+    {
+        double v = i;
+        copt.set_value(color_t{v, v, v, v});
+    }
+
+    done = true;
+    reader.join();
+    CHECK(torn == 0);
+    CHECK(copt.get_value_atomic() == color_t{100000, 100000, 100000, 100000});
+}
+
 TEST_CASE("compound options")
 {
     using namespace wf;
@@ -188,10 +248,10 @@ TEST_CASE("compound options")
 
     // Not fully specified pairs
     section->register_new_option(std::make_shared<option_t<int>>("hey_k3", 3));
-    // One of the values is a regular option with an associated XML tag, and
-    // needs to be skipped
+    // One of the values is a regular option declared in XML, and needs to be
+    // skipped
     auto xml_opt = std::make_shared<option_t<double>>("bey_k3", 5.5);
-    xml_opt->priv->xml = (xmlNode*)0x123;
+    xml_opt->priv->declared_in_xml = true;
     section->register_new_option(xml_opt);
 
     section->register_new_option(std::make_shared<option_t<std::string>>("bey_k4",
@@ -253,6 +313,143 @@ TEST_CASE("compound options")
         {"k3", "1", "invalid double"}
     };
     CHECK(!opt.set_value_untyped(v4));
+
+    // Moving a value in leaves the stored value intact
+    compound_option_t::stored_type_t v5 = {
+        {"k5", "5", "5.5"}
+    };
+    auto v5_copy = v5;
+    CHECK(opt.set_value_untyped(std::move(v5)));
+    CHECK(opt.get_value_untyped() == v5_copy);
+    CHECK(&opt.get_value_untyped() == &opt.get_value_untyped());
+
+    // Clones of an option read from XML keep the value, the type hint and
+    // the XML node
+    std::string dict_source = R"(
+<option name="Dict" type="dynamic-list" type-hint="tuple">
+<entry prefix="hey_" type="int"/>
+</option>
+)";
+    auto dict_doc = xmlParseDoc((const xmlChar*)dict_source.c_str());
+    REQUIRE(dict_doc != nullptr);
+    auto dict_node = xmlDocGetRootElement(dict_doc);
+    auto dict = std::dynamic_pointer_cast<compound_option_t>(
+        wf::config::xml::create_option_from_xml_node(dict_node));
+    REQUIRE(dict != nullptr);
+    dict->set_value<int>({{"k1", 1}});
+    auto dict_clone =
+        std::static_pointer_cast<compound_option_t>(dict->clone_option());
+    CHECK(dict_clone->get_type_hint() == "tuple");
+    CHECK(dict_clone->priv->xml == dict_node);
+    CHECK(dict_clone->priv->declared_in_xml);
+    CHECK(wf::config::xml::get_option_xml_node(dict_clone) == dict_node);
+    CHECK(dict_clone->get_value<int>() == dict->get_value<int>());
+    dict.reset();
+    dict_clone.reset();
+    xmlFreeDoc(dict_doc);
+}
+
+/** A type which counts how many times it has been parsed. */
+struct parse_counted_t
+{
+    int value;
+    bool operator ==(const parse_counted_t& other) const
+    {
+        return value == other.value;
+    }
+};
+
+static int parse_counted_parses = 0;
+
+template<>
+stdx::optional<parse_counted_t> wf::option_type::from_string(
+    const std::string& str)
+{
+    ++parse_counted_parses;
+    auto value = from_string<int>(str);
+    if (!value)
+    {
+        return {};
+    }
+
+    return parse_counted_t{value.value()};
+}
+
+template<>
+std::string wf::option_type::to_string(const parse_counted_t& value)
+{
+    return to_string<int>(value.value);
+}
+
+TEST_CASE("Compound option entries are parsed once")
+{
+    using namespace wf::config;
+
+    compound_option_t::entries_t entries;
+    entries.push_back(
+        std::make_unique<compound_option_entry_t<parse_counted_t>>("count_"));
+    compound_option_t opt{"Test", std::move(entries)};
+
+    parse_counted_parses = 0;
+    CHECK(opt.set_value_untyped({{"a", "1"}, {"b", "2"}}));
+    CHECK(parse_counted_parses == 2);
+
+    auto values = opt.get_value<parse_counted_t>();
+    REQUIRE(values.size() == 2);
+    CHECK(std::get<1>(values[0]).value == 1);
+    CHECK(std::get<1>(values[1]).value == 2);
+    CHECK(parse_counted_parses == 2);
+
+    CHECK(!opt.set_value_untyped({{"a", "invalid"}}));
+    CHECK(opt.get_value<parse_counted_t>() == values);
+
+    compound_list_t<parse_counted_t> typed = {{"c", {3}}};
+    opt.set_value(typed);
+    parse_counted_parses = 0;
+    CHECK(opt.get_value<parse_counted_t>() == typed);
+    CHECK(parse_counted_parses == 0);
+
+    auto clone =
+        std::static_pointer_cast<compound_option_t>(opt.clone_option());
+    CHECK(clone->get_value<parse_counted_t>() == typed);
+    CHECK(parse_counted_parses == 0);
+}
+
+TEST_CASE("Compound option lookup by key")
+{
+    using namespace wf::config;
+
+    compound_option_t::entries_t entries;
+    entries.push_back(
+        std::make_unique<compound_option_entry_t<parse_counted_t>>("count_"));
+    entries.push_back(std::make_unique<compound_option_entry_t<double>>("d_"));
+    compound_option_t opt{"Test", std::move(entries), "dict"};
+
+    CHECK(!opt.find<parse_counted_t, double>("a"));
+
+    CHECK(opt.set_value_untyped({{"a", "1", "1.5"}, {"b", "2", "2.5"},
+        {"a", "3", "3.5"}}));
+    parse_counted_parses = 0;
+    auto a = opt.find<parse_counted_t, double>("a");
+    REQUIRE(a);
+    CHECK(std::get<0>(*a) == "a");
+    CHECK(std::get<1>(*a).value == 1);
+    CHECK(std::get<2>(*a) == 1.5);
+    CHECK(parse_counted_parses == 0);
+    CHECK(!opt.find<parse_counted_t, double>("c"));
+
+    opt.set_value<parse_counted_t, double>({{"c", {4}, 4.5}});
+    CHECK(!opt.find<parse_counted_t, double>("a"));
+    auto c = opt.find<parse_counted_t, double>("c");
+    REQUIRE(c);
+    CHECK(std::get<1>(*c).value == 4);
+
+    auto clone =
+        std::static_pointer_cast<compound_option_t>(opt.clone_option());
+    CHECK(clone->find<parse_counted_t, double>("c") == c);
+
+    opt.reset_to_default();
+    CHECK(!opt.find<parse_counted_t, double>("c"));
 }
 
 TEST_CASE("Plain list compound options")
@@ -0,0 +1,63 @@
+/**
+ * Microbenchmark for walking over all options of a large configuration, as is
+ * done when reloading the config file. For each option, the lock status and the
+ * value are read.
+ *
+ * Reports the time per option.
+ */
+#include <wayfire/config/config-manager.hpp>
+#include <chrono>
+#include <cstdio>
+
+static const int NUM_SECTIONS = 500;
+static const int NUM_OPTIONS  = 100;
+static const int NUM_WALKS    = 20;
+
+int main()
+{
+    using namespace wf::config;
+
+    config_manager_t config;
+    for (int i = 0; i < NUM_SECTIONS; i++)
+    {
+        auto section = std::make_shared<section_t>("section" + std::to_string(i));
+        for (int j = 0; j < NUM_OPTIONS; j++)
+        {
+            section->register_new_option(std::make_shared<option_t<int>>(
+                "option" + std::to_string(j), j));
+        }
+
+        config.merge_section(section);
+    }
+
+    /* Collect the options once, so that only the options themselves are
+     * walked and not the maps of the sections. */
+    std::vector<std::shared_ptr<option_base_t>> options;
+    for (auto& section : config.get_all_sections())
+    {
+        auto section_options = section->get_registered_options();
+        options.insert(options.end(), section_options.begin(),
+            section_options.end());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    long sum   = 0;
+    for (int walk = 0; walk < NUM_WALKS; walk++)
+    {
+        for (auto& option : options)
+        {
+            if (!option->is_locked())
+            {
+                sum += static_cast<option_t<int>*>(option.get())->get_value();
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double visits = double(options.size()) * NUM_WALKS;
+    double ns     = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%zu options, %d walks (checksum %ld)\n", options.size(), NUM_WALKS, sum);
+    printf("time per option: %.2f ns\n", ns / visits);
+
+    return 0;
+}
@@ -46,3 +46,85 @@ TEST_CASE("wf::config::section_t")
     CHECK(clone->get_option_or(
         "IntOption")->get_value_str() == intopt->get_value_str());
 }
+
+TEST_CASE("wf::config::section_t option queries")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    section_t section{"Section"};
+    for (auto name : {"command_a", "command_b", "binding_a", "binding_b",
+        "command", "commands", "repeatable_binding_a"})
+    {
+        section.register_new_option(std::make_shared<option_t<int>>(name, 1));
+    }
+
+    SUBCASE("Tree")
+    {}
+
+    SUBCASE("Frozen")
+    {
+        section.freeze();
+    }
+
+    auto names = [] (const section_t::option_list_t& options)
+    {
+        std::vector<std::string> result;
+        for (auto& opt : options)
+        {
+            result.push_back(opt->get_name());
+        }
+
+        return result;
+    };
+
+    using list = std::vector<std::string>;
+    CHECK(names(section.get_options_with_prefix("command_")) ==
+        list{"command_a", "command_b"});
+    CHECK(names(section.get_options_with_prefix("command")) ==
+        list{"command", "command_a", "command_b", "commands"});
+    CHECK(names(section.get_options_with_prefix("")).size() == 7);
+    CHECK(section.get_options_with_prefix("z").empty());
+
+    CHECK(names(section.find_options("command_*")) ==
+        list{"command_a", "command_b"});
+    CHECK(names(section.find_options("*binding_a")) ==
+        list{"binding_a", "repeatable_binding_a"});
+    CHECK(names(section.find_options("command?")) == list{"commands"});
+    CHECK(names(section.find_options("[bc]*_b")) ==
+        list{"binding_b", "command_b"});
+    CHECK(names(section.find_options("command")) == list{"command"});
+    CHECK(section.find_options("command_").empty());
+}
+
+TEST_CASE("wf::config::section_t freeze")
+{
+    using namespace wf;
+    using namespace wf::config;
+
+    section_t section{"Section"};
+    auto a = std::make_shared<option_t<int>>("a", 1);
+    auto b = std::make_shared<option_t<int>>("b", 2);
+    section.register_new_option(b);
+    section.register_new_option(a);
+
+    CHECK(!section.is_frozen());
+    section.freeze();
+    CHECK(section.is_frozen());
+    CHECK(section.get_option_or("a") == a);
+    CHECK(section.get_option("b") == b);
+    CHECK(section.get_option_or("c") == nullptr);
+    CHECK(section.get_registered_options() == section_t::option_list_t{a, b});
+    CHECK(section.clone_with_name("Clone")->get_registered_options().size() == 2);
+
+    // Modifying the section thaws it
+    auto c = std::make_shared<option_t<int>>("c", 3);
+    section.register_new_option(c);
+    CHECK(!section.is_frozen());
+    CHECK(section.get_registered_options() == section_t::option_list_t{a, b, c});
+
+    section.freeze();
+    section.unregister_option(a);
+    CHECK(!section.is_frozen());
+    CHECK(section.get_registered_options() == section_t::option_list_t{b, c});
+}
@@ -110,6 +110,12 @@ TEST_CASE("wf::color_t")
     CHECK(!from_string<color_t>(""));
     CHECK(!from_string<color_t>("#ZYXUIOPQ"));
     CHECK(!from_string<color_t>("#AUIO")); // invalid color
+    CHECK(!from_string<color_t>("#66CC5EG7"));
+    CHECK(!from_string<color_t>("#66CC5E\xE9" "7"));
+    CHECK(!from_string<color_t>("#66CC5EF7 "));
+    CHECK(!from_string<color_t>("# 6CC5EF7"));
+    check_color_equals(from_string<color_t>("#ffffff00"), 1, 1, 1, 0);
+    check_color_equals(from_string<color_t>("#a0F9"), 2.0 / 3, 0, 1, 0.6);
     CHECK(!from_string<color_t>("1.0 0.5 0.5 1.0 1.0")); // invalid color
     CHECK(!from_string<color_t>("1.0 0.5 0.5 1.0 asdf")); // invalid color
     CHECK(!from_string<color_t>("1.0 0.5")); // invalid color
@@ -250,6 +256,11 @@ TEST_CASE("wf::touchgesture_t")
     CHECK(!from_string<touchgesture_t>("edge-swipe up-down 3")); // opposite dirs
     CHECK(!from_string<touchgesture_t>("swipe 3")); // missing dir
     CHECK(!from_string<touchgesture_t>("pinch 3"));
+    CHECK(!from_string<touchgesture_t>("pinch up 3")); // wrong dir for type
+    CHECK(!from_string<touchgesture_t>("swipe up-left-down 3"));
+    CHECK(!from_string<touchgesture_t>("swipe up 3f")); // bad finger count
+    CHECK(!from_string<touchgesture_t>("swipe up 0"));
+    CHECK(!from_string<touchgesture_t>("swipe up -3"));
     CHECK(!from_string<touchgesture_t>(""));
 
     /* Equality */
@@ -399,7 +410,27 @@ TEST_CASE("wf::activatorbinding_t")
     test_binding("<alt>KEY_T|<alt>KEY_T|none|hotspot left 10x10 10", 1, 0, 0, 0, 0,
         0, 1);
 
+    test_binding("hotspot left 10x10 10 | swipe up 3 | <ctrl> BTN_EXTRA",
+        0, 0, 1, 0, 1, 0, 1);
+    test_binding("  pinch in 4|<alt>KEY_T", 1, 0, 0, 0, 0, 1, 0);
+
+    auto moved_from = from_string<activatorbinding_t>("<alt> KEY_T").value();
+    activatorbinding_t moved_to{std::move(moved_from)};
+    CHECK(moved_to.has_match(kb1));
+    CHECK(moved_from == empty_binding);
+    moved_from = std::move(moved_to);
+    CHECK(moved_from.has_match(kb1));
+    CHECK(moved_to == empty_binding);
+    CHECK(!moved_to.has_match(kb1));
+    CHECK(moved_to.get_hotspots().empty());
+    CHECK(to_string(moved_to) == "");
+    activatorbinding_t copied{moved_to};
+    CHECK(copied == empty_binding);
+
     CHECK(!from_string<activatorbinding_t>("<alt> KEY_K || <alt> KEY_U"));
+    CHECK(!from_string<activatorbinding_t>("hotspot left 10x10 | <alt> KEY_K"));
+    CHECK(!from_string<activatorbinding_t>("swipe KEY_K 3"));
+    CHECK(!from_string<activatorbinding_t>("<alt> swipe up 3"));
     CHECK(!from_string<activatorbinding_t>("<alt> KEY_K | thrash"));
     CHECK(!from_string<activatorbinding_t>("<alt> KEY_K |"));
 }
@@ -499,3 +530,47 @@ TEST_CASE("wf::output_config::position_t")
     CHECK(!from_string<pt>("129 129"));
     CHECK(!from_string<pt>("129,"));
 }
+
+TEST_CASE("wf::option_type::append_to")
+{
+    using namespace wf;
+    using mt = wf::output_config::mode_t;
+    using pt = wf::output_config::position_t;
+
+    auto check_append = [] (const auto& value)
+    {
+        using type_t = std::decay_t<decltype(value)>;
+        std::string buffer = "prefix ";
+        append_to<type_t>(buffer, value);
+        CHECK(buffer == "prefix " + to_string<type_t>(value));
+    };
+
+    check_append(true);
+    check_append(-12345);
+    check_append(std::numeric_limits<int>::min());
+    check_append(3.25);
+    check_append(std::numeric_limits<double>::max());
+    check_append(std::string{"string"});
+    check_append(color_t{0.4, 0.8, 0.3686274, 0.9686274});
+    check_append(keybinding_t{KEYBOARD_MODIFIER_ALT, KEY_T});
+    check_append(keybinding_t{0, 0});
+    check_append(buttonbinding_t{KEYBOARD_MODIFIER_CTRL, BTN_EXTRA});
+    check_append(touchgesture_t{GESTURE_TYPE_EDGE_SWIPE,
+        GESTURE_DIRECTION_UP | GESTURE_DIRECTION_LEFT, 3});
+    check_append(hotspot_binding_t{OUTPUT_EDGE_TOP | OUTPUT_EDGE_LEFT, 10, 20,
+        300});
+    check_append(from_string<activatorbinding_t>(
+        "<alt> KEY_T | pinch in 4 | hotspot left 10x10 10").value());
+    check_append(activatorbinding_t{});
+    check_append(mt{1920, 1080, 59000});
+    check_append(mt{std::string{"eDP-1"}});
+    check_append(pt{-10, 20});
+    check_append(pt{});
+
+    CHECK(to_string<touchgesture_t>(touchgesture_t{GESTURE_TYPE_SWIPE,
+        GESTURE_DIRECTION_UP | GESTURE_DIRECTION_LEFT, 3}) == "swipe left-up 3");
+    CHECK(to_string<hotspot_binding_t>(hotspot_binding_t{
+        OUTPUT_EDGE_TOP | OUTPUT_EDGE_LEFT, 10, 20, 300}) ==
+        "hotspot left-top 10x20 300");
+    CHECK(to_string<mt>(mt{1920, 1080, 0}) == "1920x1080");
+}
@@ -3,6 +3,9 @@
 #include <set>
 
 #include <sstream>
+#include <fstream>
+#include <map>
+#include <unistd.h>
 #include <wayfire/config/types.hpp>
 #include <wayfire/config/compound-option.hpp>
 #include <wayfire/config/xml.hpp>
@@ -413,3 +416,108 @@ TEST_CASE("wf::config::xml::create_section")
         EXPECT_LINE(log, "is not a plugin/object element");
     }
 }
+
+TEST_CASE("wf::config::xml::load_section_from_file")
+{
+    std::stringstream log;
+    wf::log::initialize_logging(log,
+        wf::log::LOG_LEVEL_DEBUG, wf::log::LOG_COLOR_MODE_OFF);
+
+    namespace wxml = wf::config::xml;
+    namespace wc   = wf::config;
+
+    char path[] = "/tmp/wf-config-xml-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    auto load_section = [&] (std::string xml_source)
+    {
+        std::ofstream out{path};
+        out << "<?xml version=\"1.0\"?>\n<wayfire>\n<category/>\n" <<
+            xml_source << "\n</wayfire>\n";
+        out.close();
+        return wxml::load_section_from_file(path);
+    };
+
+    auto get_values = [] (std::shared_ptr<wc::section_t> section)
+    {
+        std::map<std::string, std::string> values;
+        for (auto& opt : section->get_registered_options())
+        {
+            values[opt->get_name()] = opt->get_value_str();
+        }
+
+        return values;
+    };
+
+    SUBCASE("Same options as the document tree")
+    {
+        auto section = load_section(xml_section_full);
+        REQUIRE(section != nullptr);
+        CHECK(section->get_name() == "TestPluginFull");
+        CHECK(wxml::get_section_xml_node(section) == nullptr);
+
+        auto doc = xmlParseDoc((const xmlChar*)xml_section_full.c_str());
+        REQUIRE(doc != nullptr);
+        auto expected =
+            wxml::create_section_from_xml_node(xmlDocGetRootElement(doc));
+        REQUIRE(expected != nullptr);
+        CHECK(get_values(section) == get_values(expected));
+        CHECK(wxml::get_option_xml_node(section->get_option("KeyOption")) ==
+            nullptr);
+    }
+
+    SUBCASE("Option values and bounds")
+    {
+        auto section = load_section(
+            R"(<object name="Obj">
+<option name="IntOption" type="int">
+    <default>15</default> <min>0</min> <!-- comment --> <max>10</max>
+    <desc><default>2</default></desc>
+</option>
+<option name="Empty" type="string"><default/></option>
+<option name="Comment" type="string"><default>a<!-- b --></default></option>
+)" + xml_option_dyn_list + "</object>");
+        REQUIRE(section != nullptr);
+        CHECK(section->get_name() == "Obj");
+
+        auto as_int = section->get_option("IntOption");
+        REQUIRE(as_int);
+        CHECK(as_int->get_value_str() == "10");
+        CHECK(section->get_option("Empty")->get_value_str() == "");
+        CHECK(section->get_option_or("Comment") == nullptr);
+        EXPECT_LINE(log, "option at line 10 has no default value specified");
+
+        auto as_co = std::dynamic_pointer_cast<wc::compound_option_t>(
+            section->get_option("DynList"));
+        REQUIRE(as_co != nullptr);
+        REQUIRE(as_co->get_entries().size() == 2);
+        CHECK(dynamic_cast<wc::compound_option_entry_t<wf::activatorbinding_t>*>(
+            as_co->get_entries()[1].get()));
+    }
+
+    SUBCASE("Invalid options are skipped")
+    {
+        auto section = load_section("<plugin name=\"P\">" +
+            xml_option_bad_default + xml_option_missing_type +
+            xml_option_dyn_list_no_prefix + xml_option_int + "</plugin>");
+        REQUIRE(section != nullptr);
+        CHECK(get_values(section) ==
+            std::map<std::string, std::string>{{"IntOption", "3"}});
+        EXPECT_LINE(log, "invalid default value");
+        EXPECT_LINE(log, "missing \"type\" attribute");
+        EXPECT_LINE(log, "missing \"prefix\" attribute");
+    }
+
+    SUBCASE("Invalid files")
+    {
+        CHECK(load_section(xml_section_missing_name) == nullptr);
+        EXPECT_LINE(log, "missing \"name\" attribute");
+        CHECK(load_section("<plugin name=\"P\">") == nullptr);
+        EXPECT_LINE(log, "Failed to parse XML file");
+        CHECK(load_section(xml_section_bad_tag) == nullptr);
+    }
+
+    unlink(path);
+}